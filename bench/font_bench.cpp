@@ -0,0 +1,192 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host benchmark of the text render path: the pre-rasterized bitmap font drawn by BitmapFontRender
+// against FreeType rasterizing every glyph on every draw, both into the recording TFT_eSPI
+// stand-in. The fonts are generated by tools/pio_fonts.py. See bench/README.md for how to run it.
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_ADVANCES_H
+
+#include <algorithm>
+#include <chrono>
+
+#include "BitmapFontRender.h"
+#include "ui_bitmap_font.h"
+#include "ui_font.h"
+
+#define ITERATIONS 200
+
+typedef struct Text {
+  uint16_t size;
+  const char *str;
+  int16_t x;
+  int16_t y;
+} Text;
+
+// What one repaint of the weather screen draws, sizes and positions as in main.cpp
+static const Text FRAME[] = {
+  {22, "light intensity shower rain", 120, 0},
+  {32, "21°", 130, 30},
+  {16, "68%", 140, 68},
+  {16, "1013 hPa", 125, 90},
+  {16, "3.6 m/s", 200, 90},
+  {12, "123.4/80", 45, 95},
+  {18, "MON", 30, 130}, {16, "12-19°", 30, 155},
+  {18, "TUE", 90, 130}, {16, "11-18°", 90, 155},
+  {18, "WED", 150, 130}, {16, "9-15°", 150, 155},
+  {18, "THU", 210, 130}, {16, "10-17°", 210, 155},
+  {18, "Sun", 30, 235}, {18, "Moon", 185, 235},
+  {14, "06:12", 30, 255}, {14, "20:41", 30, 270},
+  {14, "21:05", 185, 255}, {14, "07:32", 185, 270},
+  {64, "14:55", 120, 220},
+  {12, "Wednesday, 23.08.2023", 120, 300},
+};
+
+TFT_eSPI bitmapTft;
+TFT_eSPI freeTypeTft;
+OpenFontRender ofr;
+CachedFontRender cachedRender(&ofr);
+BitmapFontRender bitmapRender(&uiBitmapFont, &cachedRender);
+FT_Library library;
+FT_Face face;
+
+static void drawBitmapFrame() {
+  for (const Text &text : FRAME) {
+    bitmapRender.setFontSize(text.size);
+    bitmapRender.cdrawString(text.str, text.x, text.y);
+  }
+}
+
+// Blends the 8 bit coverage onto the display like OpenFontRender's drawer calls.
+static void blitFreeType(FT_Bitmap *bitmap, int32_t x, int32_t y) {
+  for (uint32_t r = 0; r < bitmap->rows; r++) {
+    const uint8_t *row = bitmap->buffer + r * bitmap->pitch;
+    uint32_t col = 0;
+    while (col < bitmap->width) {
+      uint8_t a = row[col];
+      uint32_t run = 1;
+      while (col + run < bitmap->width && row[col + run] == a) {
+        run++;
+      }
+      if (a != 0) {
+        uint16_t color = a == 255 ? TFT_WHITE : freeTypeTft.alphaBlend(a, TFT_WHITE, TFT_BLACK);
+        freeTypeTft.drawFastHLine(x + col, y + r, run, color);
+      }
+      col += run;
+    }
+  }
+}
+
+static void drawFreeTypeFrame() {
+  for (const Text &text : FRAME) {
+    FT_Set_Pixel_Sizes(face, 0, text.size);
+    int32_t baseline = text.y + (face->ascender * text.size + face->units_per_EM / 2) /
+                                face->units_per_EM;
+    int32_t width = 0;
+    const char *str = text.str;
+    while (uint32_t codepoint = CachedFontRender::nextCodepoint(&str)) {
+      FT_Fixed advance;
+      FT_Get_Advance(face, FT_Get_Char_Index(face, codepoint), FT_LOAD_NO_HINTING, &advance);
+      width += (advance + 0x8000) >> 16;
+    }
+    int32_t x = text.x - width / 2;
+    str = text.str;
+    while (uint32_t codepoint = CachedFontRender::nextCodepoint(&str)) {
+      FT_UInt index = FT_Get_Char_Index(face, codepoint);
+      FT_Load_Glyph(face, index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+      // unmapped characters (the font's space) advance like .notdef but aren't drawn, as in the
+      // bitmap font
+      if (index)
+        blitFreeType(&face->glyph->bitmap, x + face->glyph->bitmap_left,
+                     baseline - face->glyph->bitmap_top);
+      x += (face->glyph->linearHoriAdvance + 0x8000) >> 16;
+    }
+  }
+}
+
+// What centering the frame's strings costs: measuring each one, or looking it up in the layout cache
+static double measureLayouts(BitmapFontRender &render, bool cold) {
+  auto start = std::chrono::steady_clock::now();
+  int32_t sum = 0;
+  for (int i = 0; i < ITERATIONS; i++) {
+    if (cold)
+      render.loadFont(uiFont, sizeof(uiFont));
+    for (const Text &text : FRAME) {
+      render.setFontSize(text.size);
+      sum += render.getTextAdvance(text.str);
+    }
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+                  .count() / ITERATIONS;
+  return sum ? us : 0;
+}
+
+template <typename Draw>
+static double measure(TFT_eSPI &tft, Draw draw) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    draw();
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+                  .count() / ITERATIONS;
+  tft.fillScreen(TFT_BLACK);
+  tft.resetStats();
+  draw();
+  return us;
+}
+
+int main(int argc, char **argv) {
+  if (FT_Init_FreeType(&library) ||
+      FT_New_Memory_Face(library, uiFont, sizeof(uiFont), 0, &face)) {
+    fprintf(stderr, "Failed to load the font\n");
+    return 1;
+  }
+  cachedRender.setDrawer(bitmapTft);
+  bitmapRender.setDrawer(bitmapTft);
+  bitmapRender.setFontColor(TFT_WHITE);
+  bitmapRender.setBackgroundColor(TFT_BLACK);
+
+  size_t bitmapBytes = 2 * uiBitmapFont.glyphCount;
+  for (uint8_t i = 0; i < uiBitmapFont.sizeCount; i++) {
+    const BitmapFontSize &size = uiBitmapFont.sizes[i];
+    const BitmapFontGlyph &last = size.glyphs[uiBitmapFont.glyphCount - 1];
+    bitmapBytes = std::max(bitmapBytes, (size_t)last.offset + (last.width + 1) / 2 * last.height);
+  }
+  printf("font: %zu bytes TrueType, bitmap font %u glyphs at %u sizes, ~%zu bytes of bitmaps\n",
+         sizeof(uiFont), uiBitmapFont.glyphCount, uiBitmapFont.sizeCount, bitmapBytes);
+
+  printf("\n%-28s %10s %10s %10s\n", "one frame of text", "us/frame", "draw calls", "pixels");
+  double us = measure(freeTypeTft, drawFreeTypeFrame);
+  printf("%-28s %10.1f %10u %10u\n", "FreeType per draw", us, freeTypeTft.stats.fillCalls,
+         freeTypeTft.stats.pixelsFilled);
+  double bitmapUs = measure(bitmapTft, drawBitmapFrame);
+  printf("%-28s %10.1f %10u %10u  %.1fx faster\n", "bitmap font", bitmapUs,
+         bitmapTft.stats.fillCalls, bitmapTft.stats.pixelsFilled, us / bitmapUs);
+
+  printf("\n%-28s %10s\n", "measuring the frame's text", "us/frame");
+  printf("%-28s %10.1f\n", "every string", measureLayouts(bitmapRender, true));
+  printf("%-28s %10.1f\n", "layout cache", measureLayouts(bitmapRender, false));
+  TextLayoutCacheStats layoutStats = bitmapRender.getLayoutStats();
+  printf("layout cache: %u hits, %u misses, %u evictions, %u entries\n", layoutStats.hits,
+         layoutStats.misses, layoutStats.evictions, layoutStats.entries);
+
+  // both rasterize the same unhinted outlines, the bitmap font quantizes coverage to 4 bit
+  uint32_t differing = 0;
+  uint32_t inked = 0;
+  uint64_t error = 0;
+  for (int32_t y = 0; y < bitmapTft.height(); y++) {
+    for (int32_t x = 0; x < bitmapTft.width(); x++) {
+      int32_t a = (bitmapTft.readPixel(x, y) >> 5) & 0x3F;
+      int32_t b = (freeTypeTft.readPixel(x, y) >> 5) & 0x3F;
+      inked += a || b;
+      differing += abs(a - b) > 4;
+      error += abs(a - b);
+    }
+  }
+  printf("\n%u inked pixels, %u differ by more than 4/63, mean difference %.2f/63\n", inked,
+         differing, inked ? (double)error / inked : 0);
+  printf("strings drawn by the fallback: %u\n", ofr.rendered);
+  return differing > inked / 20 || ofr.rendered ? 1 : 0;
+}
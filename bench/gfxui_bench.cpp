@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host benchmark of the GfxUi render path against the recording TFT_eSPI and LittleFS stand-ins in
+// bench/mock. See bench/README.md for how to run it.
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "GfxUi.h"
+
+#define ITERATIONS 50
+
+static const char *ICON_DIRS[] = {"weather", "weather-small", "wind"};
+
+TFT_eSPI tft;
+OpenFontRender ofr;
+GfxUi ui(&tft, &ofr);
+
+typedef struct Measurement {
+  double nsPerPixel;
+  uint32_t bytesRead;
+  uint32_t fileOps;
+  uint32_t pushes;
+  uint32_t pixels;
+} Measurement;
+
+// Runs draw once to record the I/O and push counts, then ITERATIONS times for the timing. prepare
+// runs before every draw (e.g. to empty the icon cache) and isn't timed.
+template <typename Draw, typename Prepare>
+static Measurement measure(Draw draw, Prepare prepare) {
+  Measurement m = {};
+  prepare();
+  fsStats = {};
+  tft.resetStats();
+  draw();
+  m.bytesRead = fsStats.bytesRead;
+  m.fileOps = fsStats.exists + fsStats.opens + fsStats.reads + fsStats.seeks;
+  m.pushes = tft.stats.pushImageCalls;
+  m.pixels = tft.stats.pixelsPushed + tft.stats.pixelsFilled;
+
+  std::chrono::steady_clock::duration elapsed{};
+  for (int i = 0; i < ITERATIONS; i++) {
+    prepare();
+    auto start = std::chrono::steady_clock::now();
+    draw();
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+  m.nsPerPixel = m.pixels ? std::chrono::duration<double, std::nano>(elapsed).count() /
+                            ITERATIONS / m.pixels : 0;
+  return m;
+}
+
+template <typename Draw>
+static Measurement measure(Draw draw) {
+  return measure(draw, [] {});
+}
+
+static void printHeader(const char *title) {
+  printf("\n%-36s %8s %8s %8s %7s %8s\n", title, "ns/px", "bytes", "file ops", "pushes",
+         "pixels");
+}
+
+static void printRow(const std::string &name, const Measurement &m, const char *note = "") {
+  printf("%-36s %8.2f %8u %8u %7u %8u %s\n", name.c_str(), m.nsPerPixel, m.bytesRead, m.fileOps,
+         m.pushes, m.pixels, note);
+}
+
+static std::vector<std::string> findIcons(const std::string &dataDir) {
+  std::vector<std::string> icons;
+  for (const char *iconDir : ICON_DIRS) {
+    DIR *dir = opendir((dataDir + "/" + iconDir).c_str());
+    if (!dir)
+      continue;
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bmp") == 0)
+        icons.push_back("/" + std::string(iconDir) + "/" + name.substr(0, name.size() - 4));
+    }
+    closedir(dir);
+  }
+  std::sort(icons.begin(), icons.end());
+  return icons;
+}
+
+// Copies the screen area an icon was drawn to, to compare the output of the different paths
+static std::vector<uint16_t> snapshot(uint16_t w, uint16_t h) {
+  std::vector<uint16_t> pixels;
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++) {
+      pixels.push_back(tft.readPixel(x, y));
+    }
+  }
+  return pixels;
+}
+
+bool pushImageToTft(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
+  return ui.pushJpegBlock(x, y, w, h, bitmap);
+}
+
+int main(int argc, char **argv) {
+  std::string dataDir = argc > 1 ? argv[1] : "data";
+  std::string fsImageDir = argc > 2 ? argv[2] : ".pio/bench/fsdata";
+  std::vector<std::string> icons = findIcons(dataDir);
+  std::vector<std::vector<uint16_t>> bmpOutput;
+  int mismatches = 0;
+
+  // 1. the original BMP files
+  LittleFS.setRoot(dataDir.c_str());
+  printHeader("GfxUi::drawBmp()");
+  for (const std::string &icon : icons) {
+    tft.fillScreen(TFT_BLACK);
+    Measurement m = measure([&] { ui.drawBmp(icon + ".bmp", 0, 0); });
+    bmpOutput.push_back(snapshot(75, 75));
+    printRow(icon, m, m.pushes ? "" : "(not drawn)");
+  }
+
+  // 2. the icon atlas as built by tools/icons.py, without and with the icon cache
+  LittleFS.setRoot(fsImageDir.c_str());
+  ui.begin();
+  printHeader("GfxUi::drawIcon() cold / warm");
+  for (size_t i = 0; i < icons.size(); i++) {
+    tft.fillScreen(TFT_BLACK);
+    Measurement cold = measure([&] { ui.drawIcon(icons[i], 0, 0); }, [] { ui.clearIconCache(); });
+    bool identical = snapshot(75, 75) == bmpOutput[i];
+    Measurement warm = measure([&] { ui.drawIcon(icons[i], 0, 0); });
+    mismatches += !identical;
+    printRow(icons[i] + " (cold)", cold, identical ? "= drawBmp" : "MISMATCH");
+    printRow(icons[i] + " (warm)", warm);
+  }
+  IconCacheStats cacheStats = ui.getIconCacheStats();
+  printf("icon cache: %u hits, %u misses, %u evictions, %zu/%zu bytes\n", cacheStats.hits,
+         cacheStats.misses, cacheStats.evictions, cacheStats.bytesUsed, cacheStats.bytesBudget);
+
+  // 3. procedural moon
+  printHeader("GfxUi::drawMoon()");
+  for (double illumination : {0.0, 0.25, 0.5, 0.75, 1.0}) {
+    char name[40];
+    snprintf(name, sizeof(name), "illumination %.2f", illumination);
+    printRow(name, measure([&] { ui.drawMoon(0, 0, 50, illumination, true, false, true); }));
+    snprintf(name, sizeof(name), "illumination %.2f (aliased)", illumination);
+    printRow(name, measure([&] { ui.drawMoon(0, 0, 50, illumination, true, false, false); }));
+  }
+
+  // 4. the rest of GfxUi
+  printHeader("GfxUi misc");
+  for (uint8_t percentage : {0, 50, 100}) {
+    printRow("drawProgressBar() " + std::to_string(percentage) + "%", measure([&] {
+      ui.drawProgressBar(50, 260, 140, 15, percentage, TFT_WHITE, 0x0336);
+    }));
+  }
+  TJpgDec.setCallback(pushImageToTft);
+  LittleFS.setRoot(dataDir.c_str());
+  printRow("drawLogo()", measure([] { ui.drawLogo(); }));
+
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host benchmark: decode throughput and bytes read of the PRLE icon format compared to the
+// BMPs drawn by GfxUi::drawBmp(). See bench/README.md for how to run it.
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BmpHeader.h"
+#include "PaletteRle.h"
+
+#define ITERATIONS 200
+
+static const char *ICON_DIRS[] = {"weather", "weather-small", "wind"};
+
+// In-memory file which counts the read calls and bytes like LittleFS would see them
+typedef struct MemFile {
+  std::vector<uint8_t> data;
+  size_t pos;
+  uint32_t reads;
+  uint32_t bytesRead;
+} MemFile;
+
+static bool loadFile(const std::string &path, MemFile *file) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  uint8_t buf[4096];
+  size_t n;
+  file->data.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    file->data.insert(file->data.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+static void rewindFile(MemFile *file) {
+  file->pos = 0;
+  file->reads = 0;
+  file->bytesRead = 0;
+}
+
+static size_t readMem(void *context, uint8_t *buf, size_t len) {
+  MemFile *file = (MemFile *)context;
+  size_t n = std::min(len, file->data.size() - file->pos);
+  memcpy(buf, file->data.data() + file->pos, n);
+  file->pos += n;
+  file->reads++;
+  file->bytesRead += n;
+  return n;
+}
+
+// Same steps as GfxUi::drawBmp(), the decoded pixels are stored in wire order (big-endian).
+static bool decodeBmp(MemFile *file, std::vector<uint16_t> *out, uint16_t *w, uint16_t *h) {
+  uint8_t header[BMP_HEADER_READ_SIZE];
+  BmpInfo info;
+  if (!parseBmpHeader(header, readMem(file, header, sizeof(header)), &info))
+    return false;
+  uint16_t palette[BMP_MAX_PALETTE_SIZE] = {};
+  if (info.paletteSize) {
+    uint8_t raw[BMP_MAX_PALETTE_SIZE * 4];
+    file->pos = info.paletteOffset;
+    readMem(file, raw, info.paletteSize * 4);
+    convertBmpPalette(raw, info.paletteSize);
+    memcpy(palette, raw, info.paletteSize * sizeof(uint16_t));
+  }
+  *w = info.width;
+  *h = info.height;
+
+  file->pos = info.pixelOffset;
+  std::vector<uint8_t> lineBuffer(info.stride);
+  out->resize(*w * *h);
+  for (uint16_t row = 0; row < *h; row++) {
+    readMem(file, lineBuffer.data(), lineBuffer.size());
+    uint16_t *tptr = out->data() + (info.topDown ? row : *h - 1 - row) * *w;
+    convertBmpRow(lineBuffer.data(), tptr, info, palette);
+    for (uint16_t col = 0; col < *w; col++) {
+      tptr[col] = (tptr[col] >> 8) | (tptr[col] << 8);
+    }
+  }
+  return true;
+}
+
+static bool decodePrle(MemFile *file, std::vector<uint16_t> *out, uint16_t *w, uint16_t *h) {
+  uint8_t magic[4];
+  if (readMem(file, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, PRLE_MAGIC, 4) != 0)
+    return false;
+  PaletteRleDecoder decoder(readMem, file);
+  if (!decoder.begin())
+    return false;
+  *w = decoder.width();
+  *h = decoder.height();
+  out->resize(*w * *h);
+  for (uint16_t row = 0; row < *h; row++) {
+    if (!decoder.readRow(out->data() + row * *w))
+      return false;
+  }
+  return true;
+}
+
+typedef bool (*DecodeFn)(MemFile *, std::vector<uint16_t> *, uint16_t *, uint16_t *);
+
+typedef struct Result {
+  bool ok;
+  uint32_t reads;
+  uint32_t bytesRead;
+  double nsPerPixel;
+} Result;
+
+static Result measure(DecodeFn decode, MemFile *file, std::vector<uint16_t> *pixels) {
+  Result result = {};
+  uint16_t w = 0, h = 0;
+  rewindFile(file);
+  result.ok = decode(file, pixels, &w, &h);
+  if (!result.ok)
+    return result;
+  result.reads = file->reads;
+  result.bytesRead = file->bytesRead;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    rewindFile(file);
+    decode(file, pixels, &w, &h);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  result.nsPerPixel = std::chrono::duration<double, std::nano>(elapsed).count() /
+                      ITERATIONS / (w * h);
+  return result;
+}
+
+int main(int argc, char **argv) {
+  std::string dataDir = argc > 1 ? argv[1] : "data";
+  std::string prleDir = argc > 2 ? argv[2] : ".pio/bench/prle";
+
+  printf("%-40s %8s %6s %8s | %8s %6s %8s | %s\n", "icon", "BMP B", "reads", "ns/px",
+         "PRLE B", "reads", "ns/px", "pixels");
+  uint64_t totalBmpBytes = 0, totalPrleBytes = 0;
+  double totalBmpNs = 0, totalPrleNs = 0;
+  int compared = 0, mismatches = 0;
+
+  for (const char *iconDir : ICON_DIRS) {
+    DIR *dir = opendir((dataDir + "/" + iconDir).c_str());
+    if (!dir)
+      continue;
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bmp") == 0)
+        names.push_back(name.substr(0, name.size() - 4));
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string &name : names) {
+      std::string icon = std::string(iconDir) + "/" + name;
+      MemFile bmpFile = {}, prleFile = {};
+      std::vector<uint16_t> bmpPixels, prlePixels;
+      loadFile(dataDir + "/" + icon + ".bmp", &bmpFile);
+      Result bmp = measure(decodeBmp, &bmpFile, &bmpPixels);
+      Result prle = {};
+      if (loadFile(prleDir + "/" + icon + PRLE_EXTENSION, &prleFile))
+        prle = measure(decodePrle, &prleFile, &prlePixels);
+
+      const char *verdict = "n/a";
+      if (bmp.ok && prle.ok) {
+        compared++;
+        verdict = bmpPixels == prlePixels ? "identical" : "MISMATCH";
+        mismatches += bmpPixels != prlePixels;
+        totalBmpBytes += bmp.bytesRead;
+        totalPrleBytes += prle.bytesRead;
+        totalBmpNs += bmp.nsPerPixel;
+        totalPrleNs += prle.nsPerPixel;
+      }
+      printf("%-40s", icon.c_str());
+      if (bmp.ok)
+        printf(" %8u %6u %8.2f |", bmp.bytesRead, bmp.reads, bmp.nsPerPixel);
+      else
+        printf(" %24s |", "unsupported by drawBmp");
+      if (prle.ok)
+        printf(" %8u %6u %8.2f |", prle.bytesRead, prle.reads, prle.nsPerPixel);
+      else
+        printf(" %24s |", "missing");
+      printf(" %s\n", verdict);
+    }
+  }
+
+  if (compared) {
+    printf("\n%d icons compared: BMP %llu bytes, %.2f ns/px avg; PRLE %llu bytes (%.1f%%), "
+           "%.2f ns/px avg\n",
+           compared, (unsigned long long)totalBmpBytes, totalBmpNs / compared,
+           (unsigned long long)totalPrleBytes, 100.0 * totalPrleBytes / totalBmpBytes,
+           totalPrleNs / compared);
+  } else {
+    printf("\nNo PRLE icons found in %s, see bench/README.md.\n", prleDir.c_str());
+  }
+  return mismatches ? 1 : 0;
+}
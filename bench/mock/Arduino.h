@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for the parts of the Arduino core used by the code under benchmark.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+typedef bool boolean;
+
+class String : public std::string {
+public:
+  String() {}
+  String(const char *s) : std::string(s) {}
+  String(const std::string &s) : std::string(s) {}
+  explicit String(int value) : std::string(std::to_string(value)) {}
+  explicit String(unsigned int value) : std::string(std::to_string(value)) {}
+  String(double value, unsigned int decimals) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    assign(buf);
+  }
+  String operator+(const String &other) const { return String((std::string)*this + other); }
+  String operator+(const char *other) const { return String((std::string)*this + other); }
+  String &operator+=(const String &other) {
+    append(other);
+    return *this;
+  }
+  String &operator+=(const char *other) {
+    append(other);
+    return *this;
+  }
+  bool operator!() const { return empty(); }
+};
+
+inline String operator+(const char *a, const String &b) {
+  return String(std::string(a) + b);
+}
+
+unsigned long millis();
+unsigned long micros();
+
+// ESP32 logging macros: errors and warnings go to stderr, the rest is muted to keep the benchmark
+// output readable.
+#define log_e(format, ...) fprintf(stderr, "[E] " format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) fprintf(stderr, "[W] " format "\n", ##__VA_ARGS__)
+#define log_i(format, ...) ((void)0)
+#define log_d(format, ...) ((void)0)
+
+#define ps_malloc malloc
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for fs::File backed by a real file, counts every operation in fsStats.
+
+#pragma once
+
+#include "Arduino.h"
+
+typedef struct FsStats {
+  uint32_t exists;
+  uint32_t opens;
+  uint32_t reads;
+  uint32_t bytesRead;
+  uint32_t seeks;
+} FsStats;
+
+extern FsStats fsStats;
+
+namespace fs {
+
+class File {
+public:
+  File() {}
+  explicit File(FILE *f) : _f(f) {}
+  size_t read(uint8_t *buf, size_t len) {
+    if (!_f)
+      return 0;
+    fsStats.reads++;
+    size_t n = fread(buf, 1, len, _f);
+    fsStats.bytesRead += n;
+    return n;
+  }
+  int read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  bool seek(uint32_t pos) {
+    fsStats.seeks++;
+    return _f && fseek(_f, pos, SEEK_SET) == 0;
+  }
+  size_t position() { return _f ? ftell(_f) : 0; }
+  size_t size() {
+    if (!_f)
+      return 0;
+    long pos = ftell(_f);
+    fseek(_f, 0, SEEK_END);
+    long size = ftell(_f);
+    fseek(_f, pos, SEEK_SET);
+    return size;
+  }
+  void close() {
+    if (_f)
+      fclose(_f);
+    _f = nullptr;
+  }
+  operator bool() const { return _f != nullptr; }
+
+private:
+  FILE *_f = nullptr;
+};
+
+} // namespace fs
+
+using fs::File;
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for LittleFS, serves the files below a directory set with setRoot().
+
+#pragma once
+
+#include "FS.h"
+
+class LittleFSFS {
+public:
+  bool begin() { return true; }
+  void setRoot(const String &root) { _root = root; }
+  bool exists(const String &path) {
+    fsStats.exists++;
+    FILE *f = fopen((_root + path).c_str(), "rb");
+    if (f)
+      fclose(f);
+    return f != nullptr;
+  }
+  fs::File open(const String &path, const char *mode = "r") {
+    fsStats.opens++;
+    return fs::File(fopen((_root + path).c_str(), "rb"));
+  }
+
+private:
+  String _root = "data";
+};
+
+extern LittleFSFS LittleFS;
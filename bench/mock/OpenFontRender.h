@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for OpenFontRender. "Rasterizes" every printable character as a box with an
+// anti-aliased right column, (size / 2) wide and size high, advancing by size / 2 + 1.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class OpenFontRender {
+public:
+  template <typename T> void setDrawer(T &drawer) {
+    _drawer = &drawer;
+    _drawPixel = [](void *d, int32_t x, int32_t y, uint16_t c) { ((T *)d)->drawPixel(x, y, c); };
+  }
+  void loadFont(const unsigned char *data, size_t size) {}
+  void setFontColor(uint16_t color) { _fg = color; }
+  void setBackgroundColor(uint16_t color) { _bg = color; }
+  void setFontSize(unsigned int size) { _size = size; }
+  void drawString(const char *str, int32_t x, int32_t y) {
+    for (; *str; str++) {
+      if (*str > ' ') {
+        for (int32_t row = 0; row < (int32_t)_size; row++) {
+          for (int32_t col = 0; col < (int32_t)_size / 2; col++) {
+            _drawPixel(_drawer, x + col, y + row, col == (int32_t)_size / 2 - 1 ? half() : _fg);
+          }
+        }
+      }
+      x += _size / 2 + 1;
+    }
+    rendered++;
+  }
+  void cdrawString(const char *str, int32_t x, int32_t y) {
+    size_t len = 0;
+    while (str[len])
+      len++;
+    drawString(str, x - (int32_t)(len * (_size / 2 + 1)) / 2, y);
+  }
+  void rdrawString(const char *str, int32_t x, int32_t y) {
+    size_t len = 0;
+    while (str[len])
+      len++;
+    drawString(str, x - (int32_t)(len * (_size / 2 + 1)), y);
+  }
+  // Host only: number of strings rasterized
+  uint32_t rendered = 0;
+
+private:
+  void *_drawer = nullptr;
+  void (*_drawPixel)(void *, int32_t, int32_t, uint16_t) = nullptr;
+  uint16_t _fg = 0xFFFF;
+  uint16_t _bg = 0;
+  unsigned int _size = 16;
+  // 50 % blend of foreground and background
+  uint16_t half() { return (((_fg & 0xF7DE) >> 1) + ((_bg & 0xF7DE) >> 1)); }
+};
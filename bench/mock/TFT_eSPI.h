@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Recording host stand-in for TFT_eSPI: renders into a 240x320 RGB565 frame buffer and counts
+// the calls and pixels that would go over SPI. Sprites are the same thing with their own frame
+// buffer, their pixels only count for the display once pushed. 1 and 4 bit sprites keep a palette
+// index per pixel and expand it when pushed.
+
+#pragma once
+
+#include "Arduino.h"
+
+#define TFT_BLACK 0x0000
+#define TFT_DARKGREY 0x7BEF
+#define TFT_WHITE 0xFFFF
+
+typedef struct TftStats {
+  uint32_t pushImageCalls;
+  uint32_t pixelsPushed;
+  uint32_t fillCalls;
+  uint32_t pixelsFilled;
+} TftStats;
+
+class TFT_eSPI {
+public:
+  TFT_eSPI(int16_t w = 240, int16_t h = 320);
+  virtual ~TFT_eSPI();
+  int16_t width() { return _vpDatum ? _xWidth : _width; }
+  int16_t height() { return _vpDatum ? _yHeight : _height; }
+  bool getSwapBytes() { return _swapBytes; }
+  void setSwapBytes(bool swap) { _swapBytes = swap; }
+  void startWrite() {}
+  void endWrite() {}
+  void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+  void resetViewport();
+
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
+  // PROGMEM overload, slower on the device as it's copied pixel by pixel
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+  void fillScreen(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawPixel(int32_t x, int32_t y, uint32_t color) { fillRect(x, y, 1, 1, color); }
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { fillRect(x, y, w, 1, color); }
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { fillRect(x, y, 1, h, color); }
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  uint16_t alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc);
+
+  // Host only
+  uint16_t readPixel(int32_t x, int32_t y);
+  TftStats stats = {};
+  void resetStats() { stats = {}; }
+
+protected:
+  int16_t _width;
+  int16_t _height;
+  bool _swapBytes = false;
+  uint16_t *_frame;
+  // sprites keep their pixels in wire order like on the device, the display natively
+  bool _wireOrder = false;
+  // 16 or the bits of a palette index
+  uint8_t _depth = 16;
+  uint16_t toFrame(uint16_t c) {
+    if (_depth == 1)
+      return c != 0;
+    if (_depth == 4)
+      return c & 0x0F;
+    return _wireOrder ? (uint16_t)((c >> 8) | (c << 8)) : c;
+  }
+  // clip window, exclusive end coordinates like TFT_eSPI
+  int32_t _vpX = 0;
+  int32_t _vpY = 0;
+  int32_t _vpW;
+  int32_t _vpH;
+  // origin and size of the coordinate system if the viewport moves it (vpDatum)
+  bool _vpDatum = false;
+  int32_t _xDatum = 0;
+  int32_t _yDatum = 0;
+  int32_t _xWidth;
+  int32_t _yHeight;
+  bool clip(int32_t *x, int32_t *y, int32_t *w, int32_t *h, int32_t *dx, int32_t *dy);
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+  TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0) {
+    _parent = tft;
+    _wireOrder = true;
+  }
+  void *createSprite(int16_t w, int16_t h);
+  void deleteSprite();
+  // 1, 4 or 16, 1 and 4 bit sprites draw palette indices (1 bit: 0 or any other value)
+  void *setColorDepth(int8_t b);
+  int8_t getColorDepth() { return _depth; }
+  void createPalette(const uint16_t *palette, uint8_t colors = 16);
+  void setBitmapColor(uint16_t fg, uint16_t bg);
+  bool created() { return _frame != nullptr; }
+  void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void *getPointer() { return _frame; }
+  void pushSprite(int32_t x, int32_t y);
+  void pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+
+private:
+  TFT_eSPI *_parent;
+  uint16_t _palette[16] = {};
+};
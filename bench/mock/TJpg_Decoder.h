@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for TJpg_Decoder: reads the whole file and emits grey 16x16 MCU blocks of the
+// JPEG's real dimensions through the callback, i.e. it exercises the output path, not decoding.
+
+#pragma once
+
+#include "LittleFS.h"
+
+typedef bool (*SketchCallback)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *data);
+
+class TJpg_Decoder {
+public:
+  void setJpgScale(uint8_t scale) {}
+  void setCallback(SketchCallback callback) { _callback = callback; }
+  void getFsJpgSize(uint16_t *w, uint16_t *h, const char *path, LittleFSFS &fs);
+  void drawFsJpg(int32_t x, int32_t y, const char *path, LittleFSFS &fs);
+
+private:
+  SketchCallback _callback = nullptr;
+};
+
+extern TJpg_Decoder TJpgDec;
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for FreeRTOS queues, safe to use from several threads.
+
+#pragma once
+
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "FreeRTOS.h"
+
+typedef struct MockQueue {
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+  std::mutex mutex;
+  std::condition_variable changed;
+} MockQueue;
+
+typedef MockQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  QueueHandle_t queue = new MockQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+// Waits up to wait ticks for ready(), the queue's mutex is held by lock.
+template <typename Ready>
+static inline bool mockQueueWait(QueueHandle_t queue, std::unique_lock<std::mutex> &lock,
+                                 TickType_t wait, Ready ready) {
+  if (wait == portMAX_DELAY) {
+    queue->changed.wait(lock, ready);
+    return true;
+  }
+  return queue->changed.wait_for(lock, std::chrono::milliseconds(wait), ready);
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!mockQueueWait(queue, lock, wait, [queue] { return queue->items.size() < queue->length; }))
+    return pdFALSE;
+  const uint8_t *bytes = (const uint8_t *)item;
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!mockQueueWait(queue, lock, wait, [queue] { return !queue->items.empty(); }))
+    return pdFALSE;
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->changed.notify_all();
+  return pdTRUE;
+}
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for FreeRTOS tasks. The threads calling in are the tasks, each gets its
+// notification value on first use. xTaskCreateStatic() doesn't run anything, it registers a task
+// whose stack high water mark a benchmark can set to see how it's reported.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "FreeRTOS.h"
+
+typedef struct StaticTask_t {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t notifications = 0;
+  std::string name;
+  // bytes never touched, what uxTaskGetStackHighWaterMark() returns
+  UBaseType_t highWaterMark = 0;
+} StaticTask_t;
+
+typedef StaticTask_t *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  static thread_local StaticTask_t task;
+  return &task;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->notified.notify_one();
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  auto pending = [task] { return task->notifications > 0; };
+  if (wait == portMAX_DELAY)
+    task->notified.wait(lock, pending);
+  else
+    task->notified.wait_for(lock, std::chrono::milliseconds(wait), pending);
+  uint32_t value = task->notifications;
+  if (value > 0)
+    task->notifications = clear ? 0 : value - 1;
+  return value;
+}
+
+inline TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t depth,
+                                      void *parameter, UBaseType_t priority, StackType_t *stack,
+                                      StaticTask_t *tcb) {
+  tcb->name = name;
+  tcb->highWaterMark = depth;
+  return tcb;
+}
+
+inline const char *pcTaskGetName(TaskHandle_t task) { return task->name.c_str(); }
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return task->highWaterMark; }
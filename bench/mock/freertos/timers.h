@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host stand-in for FreeRTOS software timers. Nothing expires on its own, a benchmark reads the
+// period a timer was armed with and fires it with mockTimerFire() as the timer service task would.
+
+#pragma once
+
+#include <vector>
+
+#include "task.h"
+
+typedef struct MockTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+typedef struct MockTimer {
+  TickType_t period;
+  bool reload;
+  bool active;
+  void *id;
+  TimerCallbackFunction_t callback;
+} MockTimer;
+
+// every timer created so far, in order
+inline std::vector<TimerHandle_t> mockTimers;
+
+inline TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t reload, void *id,
+                                  TimerCallbackFunction_t callback) {
+  mockTimers.push_back(new MockTimer{period, reload != pdFALSE, false, id, callback});
+  return mockTimers.back();
+}
+
+inline BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait) {
+  timer->active = true;
+  return pdPASS;
+}
+
+inline BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait) {
+  timer->period = period;
+  timer->active = true;
+  return pdPASS;
+}
+
+inline void *pvTimerGetTimerID(TimerHandle_t timer) { return timer->id; }
+
+inline TaskHandle_t xTimerGetTimerDaemonTaskHandle() {
+  static StaticTask_t daemon;
+  daemon.name = "Tmr Svc";
+  return &daemon;
+}
+
+// Expires the timer: one-shot timers go dormant before the callback runs, like on the device.
+inline void mockTimerFire(TimerHandle_t timer) {
+  timer->active = timer->reload;
+  timer->callback(timer);
+}
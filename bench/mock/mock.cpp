@@ -0,0 +1,231 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include <chrono>
+#include <vector>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "TFT_eSPI.h"
+#include "TJpg_Decoder.h"
+
+FsStats fsStats;
+LittleFSFS LittleFS;
+TJpg_Decoder TJpgDec;
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - startTime).count();
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) {
+  _width = w;
+  _height = h;
+  _frame = (uint16_t *)calloc(w * h, sizeof(uint16_t));
+  resetViewport();
+}
+
+TFT_eSPI::~TFT_eSPI() {
+  free(_frame);
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum) {
+  _vpX = x < 0 ? 0 : x;
+  _vpY = y < 0 ? 0 : y;
+  _vpW = x + w > _width ? _width : x + w;
+  _vpH = y + h > _height ? _height : y + h;
+  // as in TFT_eSPI the origin isn't affected by clipping
+  _vpDatum = vpDatum;
+  _xDatum = vpDatum ? x : 0;
+  _yDatum = vpDatum ? y : 0;
+  _xWidth = vpDatum ? w : _width;
+  _yHeight = vpDatum ? h : _height;
+}
+
+void TFT_eSPI::resetViewport() {
+  setViewport(0, 0, _width, _height, false);
+}
+
+// Moves the rectangle into the viewport's coordinate system and crops it to the viewport, dx/dy
+// return the offset into the source image.
+bool TFT_eSPI::clip(int32_t *x, int32_t *y, int32_t *w, int32_t *h, int32_t *dx, int32_t *dy) {
+  *x += _xDatum;
+  *y += _yDatum;
+  *dx = *x < _vpX ? _vpX - *x : 0;
+  *dy = *y < _vpY ? _vpY - *y : 0;
+  int32_t x1 = *x + *w > _vpW ? _vpW : *x + *w;
+  int32_t y1 = *y + *h > _vpH ? _vpH : *y + *h;
+  *x += *dx;
+  *y += *dy;
+  *w = x1 - *x;
+  *h = y1 - *y;
+  return *w > 0 && *h > 0;
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) {
+  stats.pushImageCalls++;
+  int32_t stride = w, dx, dy;
+  if (!clip(&x, &y, &w, &h, &dx, &dy))
+    return;
+  stats.pixelsPushed += w * h;
+  for (int32_t row = 0; row < h; row++) {
+    for (int32_t col = 0; col < w; col++) {
+      uint16_t c = data[(row + dy) * stride + col + dx];
+      // without swapping the data is in wire order, i.e. big-endian
+      uint16_t native = _swapBytes ? c : (uint16_t)((c >> 8) | (c << 8));
+      _frame[(y + row) * _width + x + col] = toFrame(native);
+    }
+  }
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+  pushImage(x, y, w, h, const_cast<uint16_t *>(data));
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  stats.fillCalls++;
+  int32_t dx, dy;
+  if (!clip(&x, &y, &w, &h, &dx, &dy))
+    return;
+  stats.pixelsFilled += w * h;
+  for (int32_t row = 0; row < h; row++) {
+    for (int32_t col = 0; col < w; col++) {
+      _frame[(y + row) * _width + x + col] = toFrame(color);
+    }
+  }
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+// Corners are drawn square, good enough to count calls and pixels
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                             uint32_t color) {
+  drawRect(x, y, w, h, color);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                             uint32_t color) {
+  fillRect(x, y, w, h, color);
+}
+
+// Same arithmetic as TFT_eSPI
+uint16_t TFT_eSPI::alphaBlend(uint8_t alpha, uint16_t fgc, uint16_t bgc) {
+  uint32_t rxb = bgc & 0xF81F;
+  rxb += ((fgc & 0xF81F) - rxb) * (alpha >> 2) >> 6;
+  uint32_t xgx = bgc & 0x07E0;
+  xgx += ((fgc & 0x07E0) - xgx) * alpha >> 8;
+  return (rxb & 0xF81F) | (xgx & 0x07E0);
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height)
+    return 0;
+  // palette index, otherwise converting twice is the identity
+  return _depth < 16 ? _frame[y * _width + x] : toFrame(_frame[y * _width + x]);
+}
+
+void *TFT_eSprite::createSprite(int16_t w, int16_t h) {
+  deleteSprite();
+  _frame = (uint16_t *)calloc(w * h, sizeof(uint16_t));
+  _width = w;
+  _height = h;
+  resetViewport();
+  return _frame;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(_frame);
+  _frame = nullptr;
+  _width = _height = 0;
+  resetViewport();
+}
+
+void *TFT_eSprite::setColorDepth(int8_t b) {
+  _depth = b;
+  return _frame;
+}
+
+void TFT_eSprite::createPalette(const uint16_t *palette, uint8_t colors) {
+  memcpy(_palette, palette, colors * sizeof(uint16_t));
+}
+
+void TFT_eSprite::setBitmapColor(uint16_t fg, uint16_t bg) {
+  _palette[0] = bg;
+  _palette[1] = fg;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  pushSprite(x, y, 0, 0, _width, _height);
+}
+
+void TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw,
+                             int32_t sh) {
+  std::vector<uint16_t> pixels(sw * sh);
+  for (int32_t row = 0; row < sh; row++) {
+    memcpy(&pixels[row * sw], _frame + (sy + row) * _width + sx, sw * sizeof(uint16_t));
+  }
+  if (_depth < 16) {
+    for (uint16_t &p : pixels) {
+      p = (uint16_t)((_palette[p] >> 8) | (_palette[p] << 8));
+    }
+  }
+  bool oldSwap = _parent->getSwapBytes();
+  _parent->setSwapBytes(false);
+  _parent->pushImage(tx, ty, sw, sh, pixels.data());
+  _parent->setSwapBytes(oldSwap);
+}
+
+// Finds the SOF marker for the image dimensions
+void TJpg_Decoder::getFsJpgSize(uint16_t *w, uint16_t *h, const char *path, LittleFSFS &fs) {
+  *w = *h = 0;
+  fs::File f = fs.open(path);
+  uint8_t marker[4];
+  if (f.read(marker, 2) != 2 || marker[0] != 0xFF || marker[1] != 0xD8) {
+    f.close();
+    return;
+  }
+  while (f.read(marker, 4) == 4 && marker[0] == 0xFF) {
+    uint16_t len = (marker[2] << 8) | marker[3];
+    if (marker[1] >= 0xC0 && marker[1] <= 0xC2) {
+      uint8_t sof[5];
+      f.read(sof, sizeof(sof));
+      *h = (sof[1] << 8) | sof[2];
+      *w = (sof[3] << 8) | sof[4];
+      break;
+    }
+    f.seek(f.position() + len - 2);
+  }
+  f.close();
+}
+
+void TJpg_Decoder::drawFsJpg(int32_t x, int32_t y, const char *path, LittleFSFS &fs) {
+  uint16_t w, h;
+  getFsJpgSize(&w, &h, path, fs);
+  fs::File f = fs.open(path);
+  uint8_t buf[512];
+  while (f.read(buf, sizeof(buf)) > 0) {
+  }
+  f.close();
+
+  uint16_t block[16 * 16];
+  for (int i = 0; i < 16 * 16; i++) {
+    block[i] = TFT_DARKGREY;
+  }
+  for (uint16_t by = 0; by < h; by += 16) {
+    for (uint16_t bx = 0; bx < w; bx += 16) {
+      if (!_callback(x + bx, y + by, 16, 16, block))
+        return;
+    }
+  }
+}
@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host benchmark of the sprite pool: what SpritePool::render() pushes with budgets from one sprite
+// down to 8 row bands against drawing straight onto the recording TFT_eSPI stand-in, and the text
+// widgets drawn into 4 and 1 bit palettized sprites against RGB565 ones. The fonts are generated by
+// tools/pio_fonts.py. See bench/README.md for how to run it.
+
+#include "BitmapFontRender.h"
+#include "DigitClock.h"
+#include "SpritePool.h"
+#include "ui_bitmap_font.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+TFT_eSPI tft;
+TFT_eSPI direct;
+
+static uint32_t differingPixels(TFT_eSPI &a, TFT_eSPI &b) {
+  uint32_t differing = 0;
+  for (int32_t y = 0; y < a.height(); y++) {
+    for (int32_t x = 0; x < a.width(); x++)
+      differing += a.readPixel(x, y) != b.readPixel(x, y);
+  }
+  return differing;
+}
+
+// ----------------------------------------------------------------------------
+// Budgets: one sprite, bands, 8 row bands and nothing at all
+// ----------------------------------------------------------------------------
+#define BEHIND 0x1234
+
+// Display coordinates crossing the edges of the rectangle, drawn in every band.
+static void drawShapes(void *context, TFT_eSPI *canvas, const ScreenRect &band) {
+  canvas->fillRect(5, 100, 300, 30, 0xF800);
+  for (int16_t i = 0; i < 40; i++)
+    canvas->drawPixel(10 + i * 6, 95 + i * 2, TFT_WHITE);
+}
+
+static void benchBudgets() {
+  printf("%-8s %6s %9s %7s %9s %7s %10s %10s\n", "budget", "drawn", "checkouts", "reuses",
+         "exhausted", "banded", "peak bytes", "differing");
+  // the clock's bounds, 320 wide on a 240 wide display
+  const ScreenRect rect = {0, 88, 320, 88};
+  direct.fillScreen(BEHIND);
+  direct.setViewport(rect.x, rect.y, rect.w, rect.h, false);
+  direct.fillRect(rect.x, rect.y, rect.w, rect.h, TFT_BLACK);
+  drawShapes(nullptr, &direct, rect);
+  direct.resetViewport();
+
+  const size_t budgets[] = {64 * 1024, 20 * 1024, 5 * 1024, 1024};
+  for (size_t budget : budgets) {
+    SpritePool pool(&tft, budget);
+    bool drawn = false;
+    // the later repaints are served by the sprites kept from the first
+    for (int i = 0; i < 3; i++) {
+      tft.fillScreen(BEHIND);
+      drawn = pool.render(rect, drawShapes, nullptr, TFT_BLACK);
+    }
+    uint32_t differing = differingPixels(tft, direct);
+    SpritePoolStats stats = pool.getStats();
+    printf("%-8zu %6s %9u %7u %9u %7u %10zu %10u\n", budget, drawn ? "yes" : "no", stats.checkouts,
+           stats.reuses, stats.exhausted, stats.banded, stats.peakBytesAllocated,
+           drawn ? differing : 0);
+    check(stats.bytesInUse == 0, "every sprite checked in again");
+    check(stats.peakBytesAllocated <= budget, "the budget is kept");
+    if (budget >= 5 * 1024) {
+      check(drawn && differing == 0, "pixel-identical to drawing directly");
+      check((stats.banded == 0) == (budget == 64 * 1024), "banded only if a sprite doesn't fit");
+    } else {
+      check(!drawn && differing > 0, "not drawn if not even 8 rows fit");
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Palettized text: bytes per depth and how far the shades are from RGB565
+// ----------------------------------------------------------------------------
+OpenFontRender ofr;
+CachedFontRender cachedRender(&ofr);
+BitmapFontRender bitmapRender(&uiBitmapFont, &cachedRender);
+DigitClock digitClock(&cachedRender, 64, "0123456789:");
+TFT_eSPI rgb565;
+
+// longer than the layout cache takes, OpenFontRender draws it itself
+static const char *LONG_TEXT =
+    "a string longer than forty eight glyphs, drawn by OpenFontRender itself";
+
+static void drawText(void *context, TFT_eSPI *canvas, const ScreenRect &band) {
+  uint8_t depth = *(uint8_t *)context;
+  bitmapRender.setDrawer(*canvas, depth);
+  bitmapRender.setFontSize(12);
+  bitmapRender.cdrawString("Wednesday, 23.08.2023", 120, 150);
+  bitmapRender.setFontSize(20);
+  bitmapRender.cdrawString("abc", 60, 100);
+  bitmapRender.setFontSize(10);
+  bitmapRender.drawString(LONG_TEXT, 0, 170);
+  digitClock.draw(canvas, 120, 80, "14:55", depth);
+  bitmapRender.setDrawer(tft);
+}
+
+static void benchPalettes() {
+  printf("\n%-8s %10s %10s %14s\n", "depth", "bytes", "differing", "max green off");
+  check(digitClock.begin(&tft, TFT_WHITE, TFT_BLACK), "clock digits rendered");
+  bitmapRender.setFontColor(TFT_WHITE);
+  bitmapRender.setBackgroundColor(TFT_BLACK);
+  const ScreenRect rect = {0, 60, 240, 130};
+  const uint8_t depths[] = {16, 4, 1};
+  for (uint8_t depth : depths) {
+    SpritePool pool(&tft, 64 * 1024);
+    uint16_t palette[16];
+    if (depth < 16)
+      pool.ramp(palette, depth, TFT_WHITE, TFT_BLACK);
+    tft.fillScreen(BEHIND);
+    // index 0 is the background of a palettized sprite
+    bool drawn = pool.render(rect, drawText, &depth, depth < 16 ? 0 : TFT_BLACK, depth,
+                             depth < 16 ? palette : nullptr);
+    // RGB565 is the reference, white on black only differs in the shade of the same gray
+    uint32_t differing = 0;
+    int16_t maxGreenOff = 0;
+    for (int32_t y = 0; y < tft.height(); y++) {
+      for (int32_t x = 0; x < tft.width(); x++) {
+        uint16_t pixel = tft.readPixel(x, y);
+        if (depth == 16) {
+          rgb565.drawPixel(x, y, pixel);
+          continue;
+        }
+        int16_t off = ((pixel >> 5) & 0x3F) - ((rgb565.readPixel(x, y) >> 5) & 0x3F);
+        off = off < 0 ? -off : off;
+        differing += off > 0;
+        maxGreenOff = off > maxGreenOff ? off : maxGreenOff;
+      }
+    }
+    SpritePoolStats stats = pool.getStats();
+    printf("%-8u %10zu %10u %12d/63\n", depth, stats.peakBytesAllocated, differing, maxGreenOff);
+    check(drawn && stats.banded == 0, "drawn in one sprite");
+    check(stats.peakBytesAllocated == (size_t)rect.w * rect.h * depth / 8, "depth bits per pixel");
+    // 16 shades are at most a step of 63/15 green away, the glyph cache quantizes on top
+    if (depth == 4)
+      check(maxGreenOff <= 4, "4 bit shades within a step of RGB565");
+  }
+}
+
+int main() {
+  benchBudgets();
+  benchPalettes();
+  printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+// Host benchmark of the task plumbing: render queue, weather snapshots, scheduler, task monitor and
+// cooperative executor against the thread-backed FreeRTOS stand-ins in bench/mock/freertos. See
+// bench/README.md for how to run it.
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "CoopExecutor.h"
+#include "RenderQueue.h"
+#include "Scheduler.h"
+#include "SnapshotBuffer.h"
+#include "TaskMonitor.h"
+
+#define SNAPSHOTS 200000
+// what a slot abandoned by a failed fetch is filled with
+#define ABANDONED 0xFFFFFFFF
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("  FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Render queue: what piles up while a frame is drawn becomes one batch
+// ----------------------------------------------------------------------------
+static void benchRenderQueue() {
+  printf("Render queue\n");
+  RenderQueue queue;
+  queue.begin();
+  queue.postProgress("Updating weather...", 70);
+  queue.postClockTick();
+  queue.postLightReading(1, 2);
+  queue.postClockTick();
+  queue.postLightReading(3.5, 40);
+  queue.postWeather();
+  queue.postProgress("Ready", 100);
+  queue.postClockTick();
+  // RENDER_QUEUE_LENGTH is 8, these two don't fit and aren't waited for
+  queue.postClockTick();
+  queue.postClockTick();
+
+  RenderBatch batch;
+  bool received = queue.receive(&batch, 0);
+  RenderQueueStats stats = queue.getStats();
+  printf("  10 posts: %u queued, %u dropped, 1 batch of %u commands\n", stats.posted, stats.dropped,
+         batch.commands);
+  check(received && batch.commands == RENDER_QUEUE_LENGTH, "all queued commands in one batch");
+  check(stats.dropped == 2, "ticks posted to the full queue are dropped");
+  check(batch.clockTick && batch.weather, "ticks and weather merged");
+  check(batch.light && batch.lux == 3.5f && batch.brightness == 40,
+        "the latest light reading wins");
+  check(batch.progress && batch.progressPercentage == 100, "the latest progress step wins");
+  check(!queue.receive(&batch, 0), "nothing left after the batch");
+}
+
+// ----------------------------------------------------------------------------
+// Weather snapshots: the reader only ever sees complete ones, newest last
+// ----------------------------------------------------------------------------
+typedef struct Snapshot {
+  // every field holds the number of the snapshot, a mix means the reader saw a torn one
+  uint32_t fields[64];
+} Snapshot;
+
+static void benchSnapshots() {
+  printf("Weather snapshots\n");
+  static SnapshotBuffer<Snapshot> buffer;
+  check(buffer.current() == nullptr && !buffer.acquire(), "nothing to read before a publish");
+
+  static std::atomic<bool> reading{false};
+  std::thread writer([] {
+    // only once the reader spins, or the writer could be done before it starts
+    while (!reading.load()) {
+    }
+    for (uint32_t n = 1; n <= SNAPSHOTS; n++) {
+      // now and then a failed fetch, its slot is abandoned and must never be read
+      if (n % 7 == 0) {
+        for (uint32_t &field : buffer.beginWrite()->fields)
+          field = ABANDONED;
+      }
+      Snapshot *snapshot = buffer.beginWrite();
+      for (uint32_t &field : snapshot->fields)
+        field = n;
+      buffer.publish();
+      // a breather now and then, or on a single core the writer is done before the reader runs
+      if (n % 1000 == 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  });
+  uint32_t last = 0, seen = 0, torn = 0, backwards = 0, abandoned = 0;
+  reading.store(true);
+  while (last < SNAPSHOTS) {
+    if (!buffer.acquire())
+      continue;
+    const Snapshot *snapshot = buffer.current();
+    uint32_t n = snapshot->fields[0];
+    if (n == ABANDONED) {
+      abandoned++;
+      continue;
+    }
+    for (uint32_t field : snapshot->fields)
+      torn += field != n;
+    backwards += n <= last;
+    last = n;
+    seen++;
+  }
+  writer.join();
+  printf("  %u published, %u picked up by the reader, %u torn, %u out of order, %u abandoned\n",
+         buffer.getPublished(), seen, torn, backwards, abandoned);
+  check(buffer.getPublished() == SNAPSHOTS, "every publish counted");
+  check(torn == 0, "no torn snapshots");
+  check(backwards == 0, "snapshots picked up in order");
+  check(abandoned == 0, "abandoned slots aren't published");
+  check(last == SNAPSHOTS, "the last snapshot is picked up");
+  check(seen > 1, "the reader picked up snapshots while they were written");
+}
+
+// ----------------------------------------------------------------------------
+// Scheduler: aligned jobs fire just past the wall clock boundary, fixed rate jobs reload
+// ----------------------------------------------------------------------------
+static int clockTicks = 0;
+static void countTick(void *context) { clockTicks++; }
+
+static uint32_t msIntoMinute(TickType_t fromNow) {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return (uint32_t)(((int64_t)now.tv_sec * 1000 + now.tv_usec / 1000 + fromNow) % 60000);
+}
+
+static void benchScheduler() {
+  printf("Scheduler\n");
+  Scheduler scheduler;
+  StaticTask_t light;
+  // the stand-in timers don't expire by themselves, they're fired below
+  size_t firstTimer = mockTimers.size();
+  check(scheduler.aligned("clock", 60 * 1000, countTick, nullptr), "aligned job added");
+  check(scheduler.every("light", 3000, Scheduler::notifyTask, &light), "fixed rate job added");
+
+  TimerHandle_t clock = mockTimers[firstTimer];
+  uint32_t firstDeadline = msIntoMinute(clock->period);
+  printf("  clock armed for %u ms past the minute\n", firstDeadline);
+  check(!clock->reload, "the clock is re-armed from the wall clock every time");
+  check(firstDeadline >= SCHEDULER_ALIGN_SLACK_MS && firstDeadline <= SCHEDULER_ALIGN_SLACK_MS + 1,
+        "the clock fires just past the minute");
+  mockTimerFire(clock);
+  uint32_t nextDeadline = msIntoMinute(clock->period);
+  check(clockTicks == 1 && clock->active, "the clock fired and was re-armed");
+  check(nextDeadline >= SCHEDULER_ALIGN_SLACK_MS && nextDeadline <= SCHEDULER_ALIGN_SLACK_MS + 1,
+        "the re-armed clock fires just past the next minute");
+
+  TimerHandle_t sampler = mockTimers[firstTimer + 1];
+  check(sampler->reload && sampler->period == 3000, "the light job reloads every 3 s");
+  mockTimerFire(sampler);
+  mockTimerFire(sampler);
+  check(light.notifications == 2 && sampler->active, "the light task is notified on every expiry");
+
+  for (int i = 2; i < SCHEDULER_JOBS; i++)
+    scheduler.every("filler", 1000, countTick, nullptr);
+  check(!scheduler.every("overflow", 1000, countTick, nullptr), "jobs past SCHEDULER_JOBS refused");
+  SchedulerStats stats = scheduler.getStats();
+  printf("  %u jobs, %u wakeups\n", stats.jobs, stats.fires);
+  check(stats.fires == 3, "every expiry counted once");
+}
+
+// ----------------------------------------------------------------------------
+// Task monitor: the recommended stack covers the worst case seen plus the margin
+// ----------------------------------------------------------------------------
+static void idle(void *parameter) {}
+TASK_STACK(roomyTask, 10000);
+TASK_STACK(tightTask, 4096);
+
+static void benchTaskMonitor() {
+  printf("Task monitor\n");
+  const TaskDef tasks[] = {
+    TASK_DEF(roomyTask, idle, 10, nullptr),
+    TASK_DEF(tightTask, idle, 5, nullptr),
+  };
+  TaskMonitor monitor;
+  check(monitor.start(tasks, 2), "tasks started from the table");
+  roomyTaskTcb.highWaterMark = 7000;
+  tightTaskTcb.highWaterMark = 200;
+  monitor.sample();
+  // the worst case sticks even if a later sample shows more free stack
+  roomyTaskTcb.highWaterMark = 7500;
+  monitor.sample();
+
+  const TaskUsage *roomy = monitor.getUsage(0);
+  const TaskUsage *tight = monitor.getUsage(1);
+  printf("  %s: %u/%u bytes used at most, %u recommended\n", roomy->name,
+         roomy->stackBytes - roomy->minFreeBytes, roomy->stackBytes,
+         TaskMonitor::recommendStack(*roomy));
+  printf("  %s: %u/%u bytes used at most, %u recommended\n", tight->name,
+         tight->stackBytes - tight->minFreeBytes, tight->stackBytes,
+         TaskMonitor::recommendStack(*tight));
+  check(roomy->minFreeBytes == 7000, "the least free stack is kept");
+  // 3000 used + 25 % = 3750, rounded up to 256
+  check(TaskMonitor::recommendStack(*roomy) == 3840, "recommendation for a roomy stack");
+  check(TaskMonitor::recommendStack(*tight) > tight->stackBytes, "a tight stack is flagged");
+  monitor.report();
+}
+
+// ----------------------------------------------------------------------------
+// Cooperative executor: earlier jobs get a turn between the steps of later ones
+// ----------------------------------------------------------------------------
+static std::mutex traceMutex;
+static std::string trace;
+static CoopExecutorStats executorStats;
+
+static void note(char step) {
+  std::lock_guard<std::mutex> lock(traceMutex);
+  trace += step;
+}
+
+static CoopExecutor executor;
+
+static void render() {
+  note('R');
+  // the stats are only read on the executor's task
+  std::lock_guard<std::mutex> lock(traceMutex);
+  executorStats = executor.getStats();
+}
+static void sample() { note('L'); }
+
+static CallJob renderJob(render);
+static CallJob lightJob(sample);
+
+// four steps like the weather update, each posting something to draw
+class SteppedJob : public CoopJob {
+public:
+  bool step() override {
+    note('W');
+    renderJob.wake();
+    // woken several times during one step, it runs once
+    if (_step == 0) {
+      lightJob.wake();
+      lightJob.wake();
+      lightJob.wake();
+    }
+    return ++_step % 4 != 0;
+  }
+
+private:
+  int _step = 0;
+};
+static SteppedJob weatherJob;
+
+static void benchCoopExecutor() {
+  printf("Cooperative executor\n");
+  executor.add(&renderJob);
+  executor.add(&lightJob);
+  executor.add(&weatherJob);
+  // woken before the executor runs, like the jobs started in setup()
+  weatherJob.wake();
+  std::thread task([] { executor.run(); });
+  task.detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::string steps;
+  CoopExecutorStats stats;
+  {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    steps = trace;
+    stats = executorStats;
+  }
+  printf("  steps %s (W weather, R render, L light), %u steps, %u wakeups\n", steps.c_str(),
+         stats.steps, stats.wakeups);
+  check(steps == "WRLWRWRWR", "render between every weather step, the light sampled once");
+}
+
+int main() {
+  benchRenderQueue();
+  benchSnapshots();
+  benchScheduler();
+  benchTaskMonitor();
+  benchCoopExecutor();
+  printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+  fflush(stdout);
+  // the executor's task never returns
+  _exit(failures ? 1 : 0);
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "BandRenderer.h"
+
+BandRenderer::BandRenderer(TFT_eSPI *tft, uint16_t background) : _sprite(tft) {
+  _tft = tft;
+  _background = background;
+}
+
+bool BandRenderer::begin() {
+  if (!_sprite.createSprite(_tft->width(), BAND_HEIGHT)) {
+    log_e("Not enough memory for the %dx%d band sprite.", _tft->width(), BAND_HEIGHT);
+    return false;
+  }
+  return true;
+}
+
+void BandRenderer::render(const ScreenRect &region, BandDrawFn draw, void *context) {
+  for (int16_t y = region.y; y < region.y + region.h; y += BAND_HEIGHT) {
+    int16_t rows = region.y + region.h - y < BAND_HEIGHT ? region.y + region.h - y : BAND_HEIGHT;
+    ScreenRect band = {region.x, y, region.w, rows};
+    drawBand(band, draw, context);
+    pushBand(band);
+  }
+}
+
+void BandRenderer::drawBand(const ScreenRect &band, BandDrawFn draw, void *context) {
+  _sprite.fillSprite(_background);
+  // The origin is moved to the band's negated position, the clip window (which TFT_eSPI derives
+  // from the same values) then ends exactly at the band's bottom right corner. Draw calls entirely
+  // outside the band return early.
+  _sprite.setViewport(-band.x, -band.y, band.x + band.w, band.y + band.h, true);
+  draw(context, &_sprite, band);
+  _sprite.resetViewport();
+}
+
+void BandRenderer::pushBand(const ScreenRect &band) {
+  uint16_t *pixels = (uint16_t *)_sprite.getPointer();
+  uint16_t stride = _sprite.width();
+  // Narrower bands are packed to their own width (in place, rows only move towards the start) so
+  // they go out as one window rather than row by row.
+  if (band.w < stride) {
+    for (int16_t row = 1; row < band.h; row++) {
+      memmove(pixels + row * band.w, pixels + row * stride, band.w * sizeof(uint16_t));
+    }
+  }
+  // the sprite holds the pixels in wire order
+  bool oldSwap = _tft->getSwapBytes();
+  _tft->setSwapBytes(false);
+  _tft->pushImage(band.x, band.y, band.w, band.h, pixels);
+  _tft->setSwapBytes(oldSwap);
+}
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// Height of the band sprite, display width x BAND_HEIGHT x 2 bytes (15 KB for 240 px) is all the
+// RAM off-screen rendering takes. Must be a multiple of TILE_SIZE (see TileRenderer.h).
+#define BAND_HEIGHT 32
+
+typedef struct ScreenRect {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+} ScreenRect;
+
+// Draws everything that intersects band into canvas, in display coordinates.
+typedef void (*BandDrawFn)(void *context, TFT_eSPI *canvas, const ScreenRect &band);
+
+/**
+ * Renders an area of the display in horizontal bands through one reusable sprite: every band is
+ * cleared, drawn completely and then sent to the display in a single window. Nothing is ever
+ * visible half-drawn, and drawing cost is independent of how many passes the content needs.
+ */
+class BandRenderer {
+public:
+  BandRenderer(TFT_eSPI *tft, uint16_t background);
+  // Allocates the band sprite, returns false if out of memory.
+  bool begin();
+  // Draws and pushes region band by band.
+  void render(const ScreenRect &region, BandDrawFn draw, void *context);
+  // Clears the sprite and draws band (at most display width x BAND_HEIGHT) into it, the sprite's
+  // coordinate system is shifted so band's top left corner lands on pixel (0, 0).
+  void drawBand(const ScreenRect &band, BandDrawFn draw, void *context);
+  // Pushes the band drawn last in one window.
+  void pushBand(const ScreenRect &band);
+  TFT_eSprite *sprite() { return &_sprite; }
+
+private:
+  TFT_eSPI *_tft;
+  TFT_eSprite _sprite;
+  uint16_t _background;
+};
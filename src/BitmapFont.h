@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Anti-aliased fonts pre-rasterized at fixed pixel sizes by tools/fonts.py --bitmap. All sizes
+// share the sorted codepoint table, glyph i of every size belongs to codepoints[i]. Alpha values
+// are 4 bit, two per byte (high nibble first), rows padded to full bytes.
+
+// Glyph position relative to the pen: x from the pen, y from the top of the line
+typedef struct BitmapFontGlyph {
+  uint32_t offset;
+  uint8_t width;
+  uint8_t height;
+  int8_t left;
+  int8_t top;
+  uint8_t advance;
+} BitmapFontGlyph;
+
+// Added to the advance of left if followed by right (glyph indices), sorted by left, then right
+typedef struct BitmapFontKerning {
+  uint16_t left;
+  uint16_t right;
+  int8_t value;
+} BitmapFontKerning;
+
+typedef struct BitmapFontSize {
+  uint16_t size;
+  const BitmapFontGlyph *glyphs;
+  const BitmapFontKerning *kerning;
+  uint16_t kerningCount;
+} BitmapFontSize;
+
+typedef struct BitmapFont {
+  const uint16_t *codepoints;
+  uint16_t glyphCount;
+  const BitmapFontSize *sizes;
+  uint8_t sizeCount;
+  const uint8_t *bitmaps;
+} BitmapFont;
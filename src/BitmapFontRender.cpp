@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "BitmapFontRender.h"
+
+BitmapFontRender::BitmapFontRender(const BitmapFont *font, CachedFontRender *fallback) {
+  _font = font;
+  _fallback = fallback;
+}
+
+void BitmapFontRender::loadFont(const unsigned char *data, size_t size) {
+  _fallback->loadFont(data, size);
+  _layouts.clear();
+}
+
+void BitmapFontRender::setDrawer(TFT_eSPI &drawer, uint8_t depth) {
+  _canvas = &drawer;
+  if (depth != _depth)
+    _colorsValid = false;
+  _depth = depth;
+  _fallback->setDrawer(drawer, depth);
+}
+
+void BitmapFontRender::setFontColor(uint16_t color) {
+  _color = color;
+  _colorsValid = false;
+  _fallback->setFontColor(color);
+}
+
+void BitmapFontRender::setBackgroundColor(uint16_t color) {
+  _background = color;
+  _colorsValid = false;
+  _fallback->setBackgroundColor(color);
+}
+
+void BitmapFontRender::setFontSize(uint16_t size) {
+  _size = nullptr;
+  _fontSize = size;
+  for (uint8_t i = 0; i < _font->sizeCount; i++) {
+    if (_font->sizes[i].size == size)
+      _size = &_font->sizes[i];
+  }
+  _fallback->setFontSize(size);
+}
+
+void BitmapFontRender::drawString(const char *str, int32_t x, int32_t y) {
+  drawAligned(str, x, y, 0);
+}
+
+void BitmapFontRender::cdrawString(const char *str, int32_t x, int32_t y) {
+  drawAligned(str, x, y, 1);
+}
+
+void BitmapFontRender::rdrawString(const char *str, int32_t x, int32_t y) {
+  drawAligned(str, x, y, 2);
+}
+
+int32_t BitmapFontRender::getTextAdvance(const char *str) {
+  const TextLayout *layout = getTextLayout(str);
+  return layout ? layout->advance : -1;
+}
+
+const TextLayout *BitmapFontRender::getTextLayout(const char *str) {
+  uint32_t fontId = (uint32_t)(uintptr_t)_font;
+  uint32_t hash = TextLayoutCache::hash(str);
+  const TextLayout *cached = _layouts.get(fontId, _fontSize, hash);
+  if (cached)
+    return cached;
+  TextLayout layout;
+  if (_size && !measure(str, &layout)) {
+    // a glyph is missing, the fallback draws the string at this size
+    return _fallback->getTextLayout(str, &_fallbackLayout) ? &_fallbackLayout : nullptr;
+  }
+  if (!_size && !_fallback->getTextLayout(str, &layout))
+    return nullptr;
+  TextLayout *entry = _layouts.put(fontId, _fontSize, hash);
+  *entry = layout;
+  return entry;
+}
+
+// align: 0 left, 1 center, 2 right of x
+void BitmapFontRender::drawAligned(const char *str, int32_t x, int32_t y, uint8_t align) {
+  const TextLayout *layout = getTextLayout(str);
+  if (!layout) {
+    if (align == 0)
+      _fallback->drawString(str, x, y);
+    else if (align == 1)
+      _fallback->cdrawString(str, x, y);
+    else
+      _fallback->rdrawString(str, x, y);
+    return;
+  }
+  x -= align == 1 ? layout->advance / 2 : align == 2 ? layout->advance : 0;
+  if (_size && layout != &_fallbackLayout)
+    drawGlyphs(str, x, y);
+  else
+    _fallback->drawString(str, x, y);
+}
+
+// Advance with kerning and ink bounds from the bitmap font, false if it lacks a glyph of str.
+bool BitmapFontRender::measure(const char *str, TextLayout *layout) {
+  *layout = {};
+  int32_t x = 0;
+  int32_t previous = -1;
+  uint32_t codepoint;
+  while ((codepoint = CachedFontRender::nextCodepoint(&str)) != 0) {
+    int32_t index = glyphIndex(codepoint);
+    if (index < 0)
+      return false;
+    if (previous >= 0)
+      x += kerning(previous, index);
+    const BitmapFontGlyph &glyph = _size->glyphs[index];
+    TextLayoutCache::addInk(layout, x + glyph.left, glyph.top, glyph.width, glyph.height);
+    x += glyph.advance;
+    previous = index;
+  }
+  layout->advance = x;
+  return true;
+}
+
+// Binary search in the sorted codepoints, -1 if the font doesn't have the glyph.
+int32_t BitmapFontRender::glyphIndex(uint32_t codepoint) {
+  int32_t lo = 0;
+  int32_t hi = _font->glyphCount - 1;
+  while (lo <= hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (_font->codepoints[mid] == codepoint)
+      return mid;
+    if (_font->codepoints[mid] < codepoint)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return -1;
+}
+
+int8_t BitmapFontRender::kerning(uint16_t left, uint16_t right) {
+  int32_t lo = 0;
+  int32_t hi = _size->kerningCount - 1;
+  uint32_t key = (left << 16) | right;
+  while (lo <= hi) {
+    int32_t mid = (lo + hi) / 2;
+    const BitmapFontKerning &pair = _size->kerning[mid];
+    uint32_t pairKey = (pair.left << 16) | pair.right;
+    if (pairKey == key)
+      return pair.value;
+    if (pairKey < key)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return 0;
+}
+
+// All glyphs of str have to be in the font, see measure().
+void BitmapFontRender::drawGlyphs(const char *str, int32_t x, int32_t y) {
+  if (!_canvas)
+    return;
+  if (!_colorsValid) {
+    for (uint8_t a = 0; a < 15; a++) {
+      _colors[a] = _depth == 1 ? a >= 8
+                   : _depth == 4 ? a
+                                 : _canvas->alphaBlend(a * 17, _color, _background);
+    }
+    _colors[15] = _depth == 16 ? _color : _depth == 4 ? 15 : 1;
+    _colorsValid = true;
+  }
+  _canvas->startWrite();
+  int32_t previous = -1;
+  uint32_t codepoint;
+  while ((codepoint = CachedFontRender::nextCodepoint(&str)) != 0) {
+    int32_t index = glyphIndex(codepoint);
+    if (previous >= 0)
+      x += kerning(previous, index);
+    const BitmapFontGlyph *glyph = &_size->glyphs[index];
+    blit(glyph, x + glyph->left, y + glyph->top);
+    x += glyph->advance;
+    previous = index;
+  }
+  _canvas->endWrite();
+}
+
+// Transparent pixels are skipped like OpenFontRender does, runs of one alpha are drawn as a line.
+void BitmapFontRender::blit(const BitmapFontGlyph *glyph, int32_t x, int32_t y) {
+  const uint8_t *row = _font->bitmaps + glyph->offset;
+  uint8_t rowBytes = (glyph->width + 1) / 2;
+  for (uint8_t r = 0; r < glyph->height; r++, row += rowBytes) {
+    uint8_t col = 0;
+    while (col < glyph->width) {
+      uint8_t a = alpha(row, col);
+      uint8_t run = 1;
+      while (col + run < glyph->width && alpha(row, col + run) == a) {
+        run++;
+      }
+      // coverage too faint for a 1 bit palette is left out as well
+      if (a != 0 && (_colors[a] != 0 || _depth == 16)) {
+        if (run == 1)
+          _canvas->drawPixel(x + col, y + r, _colors[a]);
+        else
+          _canvas->drawFastHLine(x + col, y + r, run, _colors[a]);
+      }
+      col += run;
+    }
+  }
+}
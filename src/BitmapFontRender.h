@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#include "BitmapFont.h"
+#include "CachedFontRender.h"
+#include "TextLayoutCache.h"
+
+/**
+ * Text renderer with the calls main.cpp makes on OpenFontRender. Sizes the BitmapFont was
+ * rasterized at are drawn straight from flash without FreeType, with the font's advances and
+ * kerning. Other sizes, and strings with glyphs the font lacks, go to the fallback. Strings are
+ * measured once per size for centering and aligning, see TextLayoutCache.
+ */
+class BitmapFontRender {
+public:
+  BitmapFontRender(const BitmapFont *font, CachedFontRender *fallback);
+  void loadFont(const unsigned char *data, size_t size);
+  // depth 16, 4 or 1, see CachedFontRender::setDrawer()
+  void setDrawer(TFT_eSPI &drawer, uint8_t depth = 16);
+  void setFontColor(uint16_t color);
+  void setBackgroundColor(uint16_t color);
+  void setFontSize(uint16_t size);
+  void drawString(const char *str, int32_t x, int32_t y);
+  void cdrawString(const char *str, int32_t x, int32_t y);
+  void rdrawString(const char *str, int32_t x, int32_t y);
+  // Sum of advances and kerning, -1 if the string can't be measured.
+  int32_t getTextAdvance(const char *str);
+  // Advance and ink bounds of str at the current size, nullptr if it can't be measured without
+  // drawing it (only OpenFontRender itself can). Valid until the next call measuring a string.
+  const TextLayout *getTextLayout(const char *str);
+  TextLayoutCacheStats getLayoutStats() { return _layouts.getStats(); }
+
+private:
+  const BitmapFont *_font;
+  CachedFontRender *_fallback;
+  TFT_eSPI *_canvas = nullptr;
+  uint8_t _depth = 16;
+  // nullptr if the current size isn't in the font
+  const BitmapFontSize *_size = nullptr;
+  uint16_t _fontSize = 0;
+  TextLayoutCache _layouts;
+  // layout of a string at a bitmap font size that the fallback draws, these aren't cached
+  TextLayout _fallbackLayout;
+  uint16_t _color = TFT_WHITE;
+  uint16_t _background = TFT_BLACK;
+  // RGB565 or palette index per alpha value, computed on the first draw after a color or drawer
+  // change
+  uint16_t _colors[16];
+  bool _colorsValid = false;
+  int32_t glyphIndex(uint32_t codepoint);
+  int8_t kerning(uint16_t left, uint16_t right);
+  bool measure(const char *str, TextLayout *layout);
+  void drawAligned(const char *str, int32_t x, int32_t y, uint8_t align);
+  void drawGlyphs(const char *str, int32_t x, int32_t y);
+  void blit(const BitmapFontGlyph *glyph, int32_t x, int32_t y);
+  static uint8_t alpha(const uint8_t *row, uint8_t col) {
+    return col & 1 ? row[col / 2] & 0x0F : row[col / 2] >> 4;
+  }
+};
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "BmpHeader.h"
+
+#define BI_RGB 0
+#define BI_BITFIELDS 3
+
+// BMP data is stored little-endian
+static uint16_t get16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+bool parseBmpHeader(const uint8_t *buf, size_t len, BmpInfo *info) {
+  if (len < BMP_FILE_HEADER_SIZE + 40 || get16(buf) != 0x4D42)
+    return false;
+
+  const uint8_t *dib = buf + BMP_FILE_HEADER_SIZE;
+  uint32_t headerSize = get32(dib);
+  int32_t width = (int32_t)get32(dib + 4);
+  int32_t height = (int32_t)get32(dib + 8);
+  uint16_t planes = get16(dib + 12);
+  uint16_t bpp = get16(dib + 14);
+  uint32_t compression = get32(dib + 16);
+  uint32_t colorsUsed = get32(dib + 32);
+  if (headerSize < 40 || headerSize > 124 || planes != 1 || width <= 0 || width > 0xFFFF ||
+      height == 0 || height > 0xFFFF || height < -0xFFFF)
+    return false;
+
+  info->pixelOffset = get32(buf + 10);
+  info->width = width;
+  info->height = height < 0 ? -height : height;
+  info->topDown = height < 0;
+  info->bitsPerPixel = bpp;
+  info->stride = ((width * bpp + 31) / 32) * 4;
+  info->rgb555 = false;
+  info->paletteSize = 0;
+  info->paletteOffset = BMP_FILE_HEADER_SIZE + headerSize;
+
+  if (compression == BI_BITFIELDS && (bpp == 16 || bpp == 32)) {
+    // the masks are part of V2+ headers, BITMAPINFOHEADER is followed by them
+    if (BMP_FILE_HEADER_SIZE + 40 + 12 > len)
+      return false;
+    uint32_t red = get32(dib + 40);
+    uint32_t green = get32(dib + 44);
+    uint32_t blue = get32(dib + 48);
+    if (bpp == 16 && red == 0xF800 && green == 0x07E0 && blue == 0x001F)
+      return true;
+    if (bpp == 16 && red == 0x7C00 && green == 0x03E0 && blue == 0x001F) {
+      info->rgb555 = true;
+      return true;
+    }
+    return bpp == 32 && red == 0x00FF0000 && green == 0x0000FF00 && blue == 0x000000FF;
+  }
+  if (compression != BI_RGB)
+    return false;
+
+  switch (bpp) {
+  case 8:
+    info->paletteSize = colorsUsed == 0 || colorsUsed > BMP_MAX_PALETTE_SIZE
+                            ? BMP_MAX_PALETTE_SIZE : colorsUsed;
+    return true;
+  case 16:
+    // BI_RGB 16 bit is X1R5G5B5 by definition
+    info->rgb555 = true;
+    return true;
+  case 24:
+  case 32:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void convertBmpPalette(uint8_t *buf, uint16_t size) {
+  uint16_t *palette = (uint16_t *)buf;
+  for (uint16_t i = 0; i < size; i++) {
+    // entry i is read before it (or anything after it) is overwritten: 2 * i < 4 * i
+    const uint8_t *bgra = buf + 4 * i;
+    palette[i] = rgb565(bgra[2], bgra[1], bgra[0]);
+  }
+}
+
+void convertBmpRow(const uint8_t *src, uint16_t *dst, const BmpInfo &info,
+                   const uint16_t *palette) {
+  uint16_t w = info.width;
+  switch (info.bitsPerPixel) {
+  case 8:
+    for (uint16_t col = 0; col < w; col++) {
+      *dst++ = palette[*src++];
+    }
+    break;
+  case 16:
+    for (uint16_t col = 0; col < w; col++) {
+      uint16_t c = get16(src);
+      src += 2;
+      // X1R5G5B5 -> R5G6B5, the lowest green bit is replicated from the highest
+      *dst++ = info.rgb555 ? ((c & 0x7FE0) << 1) | ((c & 0x0200) >> 4) | (c & 0x001F) : c;
+    }
+    break;
+  case 24:
+  case 32:
+    for (uint16_t col = 0; col < w; col++) {
+      *dst++ = rgb565(src[2], src[1], src[0]);
+      src += info.bitsPerPixel / 8;
+    }
+    break;
+  }
+}
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BMP_FILE_HEADER_SIZE 14
+// File header + the largest info header (BITMAPV5HEADER) + the bit field masks which follow a
+// BITMAPINFOHEADER, i.e. everything needed to parse any BMP with a single read
+#define BMP_HEADER_READ_SIZE (BMP_FILE_HEADER_SIZE + 124 + 12)
+#define BMP_MAX_PALETTE_SIZE 256
+
+typedef struct BmpInfo {
+  uint32_t pixelOffset;
+  uint32_t paletteOffset;
+  uint16_t paletteSize;
+  uint16_t width;
+  uint16_t height;
+  // bytes per row incl. padding to 4 bytes
+  uint16_t stride;
+  uint8_t bitsPerPixel;
+  bool topDown;
+  // 16 bit only: X1R5G5B5 instead of R5G6B5
+  bool rgb555;
+} BmpInfo;
+
+// Parses the file and info header (BITMAPINFOHEADER, V2, V3, V4 or V5) of an uncompressed 8, 16,
+// 24 or 32 bit BMP, bottom-up or top-down. len may be smaller than BMP_HEADER_READ_SIZE for
+// small files. Returns false for anything else.
+bool parseBmpHeader(const uint8_t *buf, size_t len, BmpInfo *info);
+
+// Converts the BGRA palette entries (as stored in the file) to RGB565 in place, i.e. into the
+// first half of the same buffer.
+void convertBmpPalette(uint8_t *buf, uint16_t size);
+
+// Converts one row of BMP pixel data to (native) RGB565, palette is only used for 8 bit images.
+void convertBmpRow(const uint8_t *src, uint16_t *dst, const BmpInfo &info,
+                   const uint16_t *palette);
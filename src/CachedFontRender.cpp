@@ -0,0 +1,346 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "CachedFontRender.h"
+
+void GlyphCapture::begin(Glyph *target) {
+  _target = target;
+  _minX = _minY = INT32_MAX;
+  _maxX = _maxY = INT32_MIN;
+}
+
+// Captured white on black, the 6 bit green channel is the most precise alpha value
+void GlyphCapture::drawPixel(int32_t x, int32_t y, uint16_t color) {
+  uint8_t alpha = ((color >> 5) & 0x3F) * 255 / 63;
+  if (alpha == 0)
+    return;
+  if (!_target) {
+    _minX = x < _minX ? x : _minX;
+    _minY = y < _minY ? y : _minY;
+    _maxX = x > _maxX ? x : _maxX;
+    _maxY = y > _maxY ? y : _maxY;
+    return;
+  }
+  int32_t col = x - _target->left;
+  int32_t row = y - _target->top;
+  if (col >= 0 && row >= 0 && col < _target->width && row < _target->height)
+    _target->alpha[row * _target->width + col] = alpha;
+}
+
+void GlyphCapture::drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color) {
+  for (int32_t i = 0; i < w; i++) {
+    drawPixel(x + i, y, color);
+  }
+}
+
+void IndexedDrawer::begin(TFT_eSPI *canvas, uint8_t depth) {
+  _canvas = canvas;
+  _depth = depth;
+}
+
+void IndexedDrawer::drawPixel(int32_t x, int32_t y, uint16_t color) {
+  uint8_t alpha = (color >> 5) & 0x3F;
+  uint8_t index = _depth == 1 ? alpha >= 32 : (alpha * 15 + 31) / 63;
+  if (index)
+    _canvas->drawPixel(x, y, index);
+}
+
+void IndexedDrawer::drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color) {
+  for (int32_t i = 0; i < w; i++) {
+    drawPixel(x + i, y, color);
+  }
+}
+
+CachedFontRender::CachedFontRender(OpenFontRender *ofr) : _cache(GLYPH_CACHE_BYTES) {
+  _ofr = ofr;
+}
+
+void CachedFontRender::loadFont(const unsigned char *data, size_t size) {
+  _ofr->loadFont(data, size);
+  _fontId = (uint32_t)(uintptr_t)data;
+  memset(_referenceSizes, 0, sizeof(_referenceSizes));
+}
+
+void CachedFontRender::setDrawer(TFT_eSPI &drawer, uint8_t depth) {
+  _canvas = &drawer;
+  _depth = depth;
+  attachDrawer();
+}
+
+void CachedFontRender::setFontColor(uint16_t color) {
+  _color = color;
+  if (_depth == 16)
+    _ofr->setFontColor(color);
+}
+
+void CachedFontRender::setBackgroundColor(uint16_t color) {
+  _background = color;
+  if (_depth == 16)
+    _ofr->setBackgroundColor(color);
+}
+
+// OpenFontRender draws onto the canvas itself only what the cache can't hold, into palettized
+// canvases through the IndexedDrawer.
+void CachedFontRender::attachDrawer() {
+  if (_depth < 16) {
+    _indexed.begin(_canvas, _depth);
+    _ofr->setFontColor(TFT_WHITE);
+    _ofr->setBackgroundColor(TFT_BLACK);
+    _ofr->setDrawer(_indexed);
+    return;
+  }
+  _ofr->setFontColor(_color);
+  _ofr->setBackgroundColor(_background);
+  if (_canvas)
+    _ofr->setDrawer(*_canvas);
+}
+
+void CachedFontRender::setFontSize(uint16_t size) {
+  _fontSize = size;
+  _ofr->setFontSize(size);
+}
+
+void CachedFontRender::drawString(const char *str, int32_t x, int32_t y) {
+  const Glyph *glyphs[CACHED_FONT_MAX_GLYPHS];
+  int32_t advance;
+  uint8_t count = layout(str, glyphs, &advance);
+  if (advance < 0) {
+    _ofr->drawString(str, x, y);
+    return;
+  }
+  drawGlyphs(glyphs, count, x, y);
+}
+
+void CachedFontRender::cdrawString(const char *str, int32_t x, int32_t y) {
+  const Glyph *glyphs[CACHED_FONT_MAX_GLYPHS];
+  int32_t advance;
+  uint8_t count = layout(str, glyphs, &advance);
+  if (advance < 0) {
+    _ofr->cdrawString(str, x, y);
+    return;
+  }
+  drawGlyphs(glyphs, count, x - advance / 2, y);
+}
+
+void CachedFontRender::rdrawString(const char *str, int32_t x, int32_t y) {
+  const Glyph *glyphs[CACHED_FONT_MAX_GLYPHS];
+  int32_t advance;
+  uint8_t count = layout(str, glyphs, &advance);
+  if (advance < 0) {
+    _ofr->rdrawString(str, x, y);
+    return;
+  }
+  drawGlyphs(glyphs, count, x - advance, y);
+}
+
+int32_t CachedFontRender::getTextAdvance(const char *str) {
+  const Glyph *glyphs[CACHED_FONT_MAX_GLYPHS];
+  int32_t advance;
+  layout(str, glyphs, &advance);
+  return advance;
+}
+
+bool CachedFontRender::getTextLayout(const char *str, TextLayout *textLayout) {
+  const Glyph *glyphs[CACHED_FONT_MAX_GLYPHS];
+  int32_t advance;
+  uint8_t count = layout(str, glyphs, &advance);
+  if (advance < 0)
+    return false;
+  *textLayout = {};
+  int32_t x = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    TextLayoutCache::addInk(textLayout, x + glyphs[i]->left, glyphs[i]->top, glyphs[i]->width,
+                            glyphs[i]->height);
+    x += glyphs[i]->advance;
+  }
+  textLayout->advance = advance;
+  return true;
+}
+
+// Looks up (rasterizing if needed) all glyphs of str, advance is -1 if any of them isn't cached.
+uint8_t CachedFontRender::layout(const char *str, const Glyph **glyphs, int32_t *advance) {
+  *advance = 0;
+  uint8_t count = 0;
+  uint32_t codepoints[CACHED_FONT_MAX_GLYPHS];
+  uint32_t evictions = _cache.getStats().evictions;
+  uint32_t codepoint;
+  while ((codepoint = nextCodepoint(&str)) != 0) {
+    const Glyph *g = count < CACHED_FONT_MAX_GLYPHS ? glyph(codepoint) : nullptr;
+    if (!g) {
+      *advance = -1;
+      return 0;
+    }
+    codepoints[count] = codepoint;
+    glyphs[count++] = g;
+    *advance += g->advance;
+  }
+  // a cache smaller than the string's glyphs may have evicted earlier ones of them again
+  if (_cache.getStats().evictions != evictions) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (glyphs[i]->codepoint != codepoints[i] || glyphs[i]->fontSize != _fontSize) {
+        *advance = -1;
+        return 0;
+      }
+    }
+  }
+  return count;
+}
+
+const Glyph *CachedFontRender::glyph(uint32_t codepoint) {
+  const Glyph *g = _cache.get(_fontId, _fontSize, codepoint);
+  return g ? g : rasterize(codepoint);
+}
+
+// Draws the glyph with OpenFontRender into the capture drawer, once for its bounding box and once
+// into the cache entry sized accordingly.
+const Glyph *CachedFontRender::rasterize(uint32_t codepoint) {
+  char utf8[5];
+  encodeUtf8(codepoint, utf8);
+  int32_t advance = measureAdvance(utf8);
+
+  _ofr->setFontColor(TFT_WHITE);
+  _ofr->setBackgroundColor(TFT_BLACK);
+  _ofr->setDrawer(_capture);
+  _capture.begin(nullptr);
+  _ofr->drawString(utf8, 0, 0);
+  bool empty = _capture.empty();
+  uint16_t w = empty ? 0 : _capture._maxX - _capture._minX + 1;
+  uint16_t h = empty ? 0 : _capture._maxY - _capture._minY + 1;
+  int16_t left = empty ? 0 : _capture._minX;
+  int16_t top = empty ? 0 : _capture._minY;
+
+  Glyph *g = _cache.put(_fontId, _fontSize, codepoint, w, h);
+  if (g) {
+    g->left = left;
+    g->top = top;
+    g->advance = advance;
+    if (g->alpha) {
+      memset(g->alpha, 0, w * h);
+      _capture.begin(g);
+      _ofr->drawString(utf8, 0, 0);
+    }
+  }
+
+  attachDrawer();
+  return g;
+}
+
+// The reference glyph drawn after utf8 moves right by utf8's advance (plus kerning of the pair,
+// the reference is chosen to have none).
+int32_t CachedFontRender::measureAdvance(const char *utf8) {
+  uint8_t slot = CACHED_FONT_REFERENCE_SIZES;
+  for (uint8_t i = 0; i < CACHED_FONT_REFERENCE_SIZES; i++) {
+    if (_referenceSizes[i] == _fontSize)
+      slot = i;
+  }
+  if (slot == CACHED_FONT_REFERENCE_SIZES) {
+    slot = _nextReference;
+    _nextReference = (_nextReference + 1) % CACHED_FONT_REFERENCE_SIZES;
+    _referenceSizes[slot] = _fontSize;
+    _referenceRight[slot] = captureBounds(CACHED_FONT_REFERENCE_GLYPH);
+  }
+  String pair = String(utf8) + CACHED_FONT_REFERENCE_GLYPH;
+  return captureBounds(pair.c_str()) - _referenceRight[slot];
+}
+
+int32_t CachedFontRender::captureBounds(const char *str) {
+  _ofr->setFontColor(TFT_WHITE);
+  _ofr->setBackgroundColor(TFT_BLACK);
+  _ofr->setDrawer(_capture);
+  _capture.begin(nullptr);
+  _ofr->drawString(str, 0, 0);
+  return _capture._maxX;
+}
+
+void CachedFontRender::drawGlyphs(const Glyph **glyphs, uint8_t count, int32_t x, int32_t y) {
+  if (!_canvas)
+    return;
+  _canvas->startWrite();
+  for (uint8_t i = 0; i < count; i++) {
+    if (glyphs[i]->alpha)
+      blit(glyphs[i], x + glyphs[i]->left, y + glyphs[i]->top);
+    x += glyphs[i]->advance;
+  }
+  _canvas->endWrite();
+}
+
+// Transparent pixels are skipped like OpenFontRender does, runs of one color are drawn as a line.
+void CachedFontRender::blit(const Glyph *glyph, int32_t x, int32_t y) {
+  const uint8_t *alpha = glyph->alpha;
+  for (uint16_t row = 0; row < glyph->height; row++) {
+    uint16_t col = 0;
+    while (col < glyph->width) {
+      uint8_t a = alpha[col];
+      if (a == 0) {
+        col++;
+        continue;
+      }
+      uint16_t run = 1;
+      while (col + run < glyph->width && alpha[col + run] == a) {
+        run++;
+      }
+      uint16_t color;
+      if (_depth == 1)
+        color = a >= 128;
+      else if (_depth == 4)
+        color = (a * 15 + 127) / 255;
+      else
+        color = a == 255 ? _color : _canvas->alphaBlend(a, _color, _background);
+      // coverage too faint for the palette
+      if (color == 0 && _depth < 16) {
+        col += run;
+        continue;
+      }
+      if (run == 1)
+        _canvas->drawPixel(x + col, y + row, color);
+      else
+        _canvas->drawFastHLine(x + col, y + row, run, color);
+      col += run;
+    }
+    alpha += glyph->width;
+  }
+}
+
+// Decodes the next UTF-8 sequence, 0 at the end of the string. Invalid bytes are skipped.
+uint32_t CachedFontRender::nextCodepoint(const char **str) {
+  const uint8_t *p = (const uint8_t *)*str;
+  while (*p) {
+    uint8_t length = *p < 0x80 ? 1 : (*p & 0xE0) == 0xC0 ? 2 : (*p & 0xF0) == 0xE0 ? 3
+                                   : (*p & 0xF8) == 0xF0 ? 4 : 0;
+    if (length == 0) {
+      p++;
+      continue;
+    }
+    uint32_t codepoint = length == 1 ? *p : *p & (0x7F >> length);
+    uint8_t i = 1;
+    for (; i < length && (p[i] & 0xC0) == 0x80; i++) {
+      codepoint = (codepoint << 6) | (p[i] & 0x3F);
+    }
+    p += i;
+    if (i == length) {
+      *str = (const char *)p;
+      return codepoint;
+    }
+  }
+  *str = (const char *)p;
+  return 0;
+}
+
+void CachedFontRender::encodeUtf8(uint32_t codepoint, char *buf) {
+  if (codepoint < 0x80) {
+    *buf++ = codepoint;
+  } else if (codepoint < 0x800) {
+    *buf++ = 0xC0 | (codepoint >> 6);
+    *buf++ = 0x80 | (codepoint & 0x3F);
+  } else if (codepoint < 0x10000) {
+    *buf++ = 0xE0 | (codepoint >> 12);
+    *buf++ = 0x80 | ((codepoint >> 6) & 0x3F);
+    *buf++ = 0x80 | (codepoint & 0x3F);
+  } else {
+    *buf++ = 0xF0 | (codepoint >> 18);
+    *buf++ = 0x80 | ((codepoint >> 12) & 0x3F);
+    *buf++ = 0x80 | ((codepoint >> 6) & 0x3F);
+    *buf++ = 0x80 | (codepoint & 0x3F);
+  }
+  *buf = 0;
+}
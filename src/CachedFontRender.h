@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <OpenFontRender.h>
+#include <TFT_eSPI.h>
+
+#include "GlyphCache.h"
+#include "TextLayoutCache.h"
+
+// Longer strings are drawn by OpenFontRender directly
+#define CACHED_FONT_MAX_GLYPHS 48
+// Glyph whose position after another glyph yields that glyph's advance, see measureAdvance()
+#define CACHED_FONT_REFERENCE_GLYPH "|"
+#define CACHED_FONT_REFERENCE_SIZES 8
+
+// OpenFontRender drawer which records the pixels of a single glyph instead of drawing them.
+class GlyphCapture {
+public:
+  // target nullptr: only determine the bounding box
+  void begin(Glyph *target);
+  void drawPixel(int32_t x, int32_t y, uint16_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color);
+  void startWrite() {}
+  void endWrite() {}
+  bool empty() { return _maxX < _minX; }
+  int32_t _minX, _minY, _maxX, _maxY;
+
+private:
+  Glyph *_target;
+};
+
+// OpenFontRender drawer which writes the coverage of white on black text into a palettized canvas
+// as palette indices, see CachedFontRender::setDrawer().
+class IndexedDrawer {
+public:
+  void begin(TFT_eSPI *canvas, uint8_t depth);
+  void drawPixel(int32_t x, int32_t y, uint16_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint16_t color);
+  void startWrite() { _canvas->startWrite(); }
+  void endWrite() { _canvas->endWrite(); }
+
+private:
+  TFT_eSPI *_canvas;
+  uint8_t _depth;
+};
+
+/**
+ * Drop-in wrapper around OpenFontRender for the calls main.cpp makes. Glyphs are rasterized by
+ * OpenFontRender once per (font, size, codepoint), captured as alpha masks into a GlyphCache and
+ * blitted from there; FreeType is only involved on cache misses. Glyphs are placed at their
+ * advance widths without pair kerning, strings are centered on their advance width.
+ */
+class CachedFontRender {
+public:
+  CachedFontRender(OpenFontRender *ofr);
+  void loadFont(const unsigned char *data, size_t size);
+  // depth 16: RGB565 canvas. 4 or 1: palettized sprite of that depth whose palette ramps from the
+  // background (index 0) to the font color (the highest index), coverage is written as index.
+  void setDrawer(TFT_eSPI &drawer, uint8_t depth = 16);
+  void setFontColor(uint16_t color);
+  void setBackgroundColor(uint16_t color);
+  void setFontSize(uint16_t size);
+  uint16_t getFontSize() { return _fontSize; }
+  void drawString(const char *str, int32_t x, int32_t y);
+  void cdrawString(const char *str, int32_t x, int32_t y);
+  void rdrawString(const char *str, int32_t x, int32_t y);
+  // Sum of the advance widths, -1 if the string can't be drawn from the cache.
+  int32_t getTextAdvance(const char *str);
+  // Advance and ink bounds of str from the cached glyphs, false if it can't be drawn from the
+  // cache.
+  bool getTextLayout(const char *str, TextLayout *layout);
+  // The glyph at the current font size, rasterized if needed. Only valid until the next call that
+  // may rasterize, nullptr if it can't be cached.
+  const Glyph *getGlyph(uint32_t codepoint) { return glyph(codepoint); }
+  GlyphCacheStats getStats() { return _cache.getStats(); }
+  // Drops all cached glyphs and frees the cache's memory until the next glyph is rasterized.
+  void freeCache() { _cache.freeArena(); }
+  // Decodes the next UTF-8 sequence and advances str past it, 0 at the end of the string.
+  static uint32_t nextCodepoint(const char **str);
+
+private:
+  OpenFontRender *_ofr;
+  TFT_eSPI *_canvas = nullptr;
+  GlyphCache _cache;
+  GlyphCapture _capture;
+  IndexedDrawer _indexed;
+  uint8_t _depth = 16;
+  uint32_t _fontId = 0;
+  uint16_t _fontSize = 0;
+  uint16_t _color = TFT_WHITE;
+  uint16_t _background = TFT_BLACK;
+  // right edge of the reference glyph per font size
+  uint16_t _referenceSizes[CACHED_FONT_REFERENCE_SIZES] = {};
+  int32_t _referenceRight[CACHED_FONT_REFERENCE_SIZES];
+  uint8_t _nextReference = 0;
+  void attachDrawer();
+  const Glyph *glyph(uint32_t codepoint);
+  const Glyph *rasterize(uint32_t codepoint);
+  int32_t measureAdvance(const char *utf8);
+  int32_t captureBounds(const char *str);
+  void drawGlyphs(const Glyph **glyphs, uint8_t count, int32_t x, int32_t y);
+  void blit(const Glyph *glyph, int32_t x, int32_t y);
+  uint8_t layout(const char *str, const Glyph **glyphs, int32_t *advance);
+  static void encodeUtf8(uint32_t codepoint, char *buf);
+};
@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "CoopExecutor.h"
+
+void CoopJob::wake() {
+  _pending.store(true);
+  if (_executor)
+    _executor->notify();
+}
+
+bool CoopExecutor::add(CoopJob *job) {
+  if (_count == COOP_EXECUTOR_JOBS) {
+    log_e("No room for another job, raise COOP_EXECUTOR_JOBS.");
+    return false;
+  }
+  job->_executor = this;
+  _jobs[_count++] = job;
+  return true;
+}
+
+void CoopExecutor::run() {
+  // jobs woken before the task ran are pending, they're stepped right away
+  _task.store(xTaskGetCurrentTaskHandle());
+  for (;;) {
+    while (stepNext()) {
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    _stats.wakeups++;
+  }
+}
+
+void CoopExecutor::notify() {
+  TaskHandle_t task = _task.load();
+  if (task)
+    xTaskNotifyGive(task);
+}
+
+bool CoopExecutor::stepNext() {
+  for (uint8_t i = 0; i < _count; i++) {
+    CoopJob *job = _jobs[i];
+    // cleared before the step, a wake during it has the job stepped again
+    if (!job->_pending.exchange(false))
+      continue;
+    _stats.steps++;
+    if (job->step())
+      job->_pending.store(true);
+    return true;
+  }
+  return false;
+}
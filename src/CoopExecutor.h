@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Jobs one executor can run
+#ifndef COOP_EXECUTOR_JOBS
+  #define COOP_EXECUTOR_JOBS 4
+#endif
+
+class CoopExecutor;
+
+/**
+ * A resumable piece of work without a stack of its own. step() does the next part and returns
+ * whether there is more to do right away; whatever has to survive until the next step is kept in
+ * members. A job whose step() returned false sleeps until it's woken.
+ */
+class CoopJob {
+public:
+  virtual bool step() = 0;
+  // Has the job stepped, from any task or a timer callback.
+  void wake();
+  // A ScheduledFn waking the CoopJob passed as context.
+  static void wakeJob(void *job) { ((CoopJob *)job)->wake(); }
+
+private:
+  friend class CoopExecutor;
+  CoopExecutor *_executor = nullptr;
+  std::atomic<bool> _pending{false};
+};
+
+// A job doing all its work in one step.
+class CallJob : public CoopJob {
+public:
+  CallJob(void (*function)()) : _function(function) {}
+  bool step() override {
+    _function();
+    return false;
+  }
+
+private:
+  void (*_function)();
+};
+
+typedef struct CoopExecutorStats {
+  // times the executor task woke up
+  uint32_t wakeups;
+  uint32_t steps;
+} CoopExecutorStats;
+
+/**
+ * Runs jobs cooperatively on the one task calling run(), which sleeps until a job is woken, e.g.
+ * by a scheduler timer. Jobs are tried in the order they were added and the first one is checked
+ * again after every step, so a job added early gets its turn between the steps of a long one.
+ */
+class CoopExecutor {
+public:
+  // false if there are already COOP_EXECUTOR_JOBS jobs
+  bool add(CoopJob *job);
+  // Steps the jobs woken so far and then those woken later, never returns.
+  void run();
+  // Not synchronized, to be called from a job, i.e. on the executor's task.
+  CoopExecutorStats getStats() { return _stats; }
+
+private:
+  friend class CoopJob;
+  CoopJob *_jobs[COOP_EXECUTOR_JOBS] = {};
+  uint8_t _count = 0;
+  std::atomic<TaskHandle_t> _task{nullptr};
+  CoopExecutorStats _stats = {};
+  void notify();
+  // Steps the first pending job, false if none was.
+  bool stepNext();
+};
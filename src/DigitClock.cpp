@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "DigitClock.h"
+
+DigitClock::DigitClock(CachedFontRender *font, uint16_t fontSize, const char *glyphs) {
+  _font = font;
+  _fontSize = fontSize;
+  _glyphs = glyphs;
+}
+
+bool DigitClock::begin(TFT_eSPI *tft, uint16_t color, uint16_t background) {
+  // called again, the atlas is rasterized anew, e.g. in other colors
+  release();
+  if (rasterize(tft, color, background))
+    return true;
+  release();
+  return false;
+}
+
+void DigitClock::release() {
+  _cellCount = 0;
+  free(_cells);
+  _cells = nullptr;
+  free(_atlas);
+  _atlas = nullptr;
+  free(_pixels);
+  _pixels = nullptr;
+  _drawn[0] = '\0';
+}
+
+// Builds the cells and the atlas, what it allocated is left for release() if it fails.
+bool DigitClock::rasterize(TFT_eSPI *tft, uint16_t color, uint16_t background) {
+  uint8_t count = strlen(_glyphs);
+  _cells = (Cell *)calloc(count, sizeof(Cell));
+  if (!_cells)
+    return false;
+  _font->setFontSize(_fontSize);
+
+  // the cells span the ink of all glyphs vertically
+  int16_t top = INT16_MAX;
+  int16_t bottom = INT16_MIN;
+  uint16_t maxWidth = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const Glyph *g = _font->getGlyph(_glyphs[i]);
+    if (!g) {
+      log_w("Can't rasterize '%c' for the clock.", _glyphs[i]);
+      return false;
+    }
+    if (g->alpha) {
+      top = g->top < top ? g->top : top;
+      bottom = g->top + g->height > bottom ? g->top + g->height : bottom;
+    }
+    _cells[i].c = _glyphs[i];
+    _cells[i].width = g->advance > 0 ? g->advance : 0;
+    maxWidth = _cells[i].width > maxWidth ? _cells[i].width : maxWidth;
+  }
+  if (bottom <= top)
+    return false;
+  _top = top;
+  _height = bottom - top;
+
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    _cells[i].offset = bytes;
+    bytes += (_cells[i].width + 1) / 2 * _height;
+  }
+  _atlas = (uint8_t *)calloc(bytes, 1);
+  _pixels = (uint16_t *)malloc(maxWidth * _height * sizeof(uint16_t));
+  if (!_atlas || !_pixels) {
+    log_w("Failed to allocate %u bytes for the clock atlas.",
+          (unsigned)(bytes + maxWidth * _height * 2));
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    // looked up again, rasterizing the other glyphs may have evicted it
+    const Glyph *g = _font->getGlyph(_glyphs[i]);
+    if (!g)
+      return false;
+    uint8_t *row = _atlas + _cells[i].offset;
+    for (uint16_t y = 0; y < _height; y++, row += (_cells[i].width + 1) / 2) {
+      int32_t gy = y + _top - g->top;
+      if (!g->alpha || gy < 0 || gy >= g->height)
+        continue;
+      for (uint16_t x = 0; x < _cells[i].width; x++) {
+        int32_t gx = x - g->left;
+        if (gx < 0 || gx >= g->width)
+          continue;
+        uint8_t alpha = (g->alpha[gy * g->width + gx] + 8) / 17;
+        row[x / 2] |= x & 1 ? alpha : alpha << 4;
+      }
+    }
+  }
+
+  for (uint8_t a = 0; a < 15; a++) {
+    _colors[a] = tft->alphaBlend(a * 17, color, background);
+  }
+  _colors[15] = color;
+  _cellCount = count;
+  log_i("Clock atlas: %d glyphs, %u bytes, cells %d px high", count, (unsigned)bytes, _height);
+  return true;
+}
+
+bool DigitClock::draw(TFT_eSPI *canvas, int32_t x, int32_t y, const char *time,
+                      uint8_t depth) {
+  const Cell *cells[DIGIT_CLOCK_MAX_CELLS];
+  int32_t width = layout(time, cells);
+  if (width < 0) {
+    // whatever is drawn there instead, update() mustn't push cells over it
+    _drawn[0] = '\0';
+    return false;
+  }
+  int32_t pen = x - width / 2;
+  for (uint8_t i = 0; time[i]; i++) {
+    if (depth == 16)
+      pushCell(canvas, cells[i], pen, y + _top);
+    else
+      drawIndexedCell(canvas, cells[i], pen, y + _top, depth);
+    pen += cells[i]->width;
+  }
+  strcpy(_drawn, time);
+  _drawnX = x;
+  _drawnY = y;
+  return true;
+}
+
+int8_t DigitClock::update(TFT_eSPI *canvas, int32_t x, int32_t y, const char *time) {
+  const Cell *cells[DIGIT_CLOCK_MAX_CELLS];
+  const Cell *drawnCells[DIGIT_CLOCK_MAX_CELLS];
+  int32_t width = layout(time, cells);
+  if (width < 0 || x != _drawnX || y != _drawnY || strlen(time) != strlen(_drawn) ||
+      layout(_drawn, drawnCells) != width)
+    return -1;
+
+  // the cells of both strings tile the same span, a cell at the same place showing the same
+  // character is already on the canvas
+  int32_t pen = x - width / 2;
+  int32_t drawnPen = pen;
+  int8_t pushed = 0;
+  for (uint8_t i = 0; time[i]; i++) {
+    if (time[i] != _drawn[i] || pen != drawnPen) {
+      pushCell(canvas, cells[i], pen, y + _top);
+      pushed++;
+    }
+    pen += cells[i]->width;
+    drawnPen += drawnCells[i]->width;
+  }
+  strcpy(_drawn, time);
+  return pushed;
+}
+
+const DigitClock::Cell *DigitClock::findCell(char c) {
+  for (uint8_t i = 0; i < _cellCount; i++) {
+    if (_cells[i].c == c)
+      return &_cells[i];
+  }
+  return nullptr;
+}
+
+// Total advance of time, -1 if it can't be drawn from the atlas.
+int32_t DigitClock::layout(const char *time, const Cell **cells) {
+  if (strlen(time) > DIGIT_CLOCK_MAX_CELLS)
+    return -1;
+  int32_t width = 0;
+  for (uint8_t i = 0; time[i]; i++) {
+    cells[i] = findCell(time[i]);
+    if (!cells[i])
+      return -1;
+    width += cells[i]->width;
+  }
+  return width;
+}
+
+void DigitClock::pushCell(TFT_eSPI *canvas, const Cell *cell, int32_t x, int32_t y) {
+  if (cell->width == 0)
+    return;
+  const uint8_t *row = _atlas + cell->offset;
+  uint16_t *out = _pixels;
+  for (uint16_t r = 0; r < _height; r++, row += (cell->width + 1) / 2) {
+    for (uint16_t c = 0; c < cell->width; c++) {
+      *out++ = _colors[c & 1 ? row[c / 2] & 0x0F : row[c / 2] >> 4];
+    }
+  }
+  bool oldSwap = canvas->getSwapBytes();
+  canvas->setSwapBytes(true);
+  canvas->pushImage(x, y, cell->width, _height, _pixels);
+  canvas->setSwapBytes(oldSwap);
+}
+
+// The alpha values are the palette indices of a 4 bit ramp, runs of one index are drawn as a line.
+void DigitClock::drawIndexedCell(TFT_eSPI *canvas, const Cell *cell, int32_t x, int32_t y,
+                                 uint8_t depth) {
+  const uint8_t *row = _atlas + cell->offset;
+  for (uint16_t r = 0; r < _height; r++, row += (cell->width + 1) / 2) {
+    uint16_t c = 0;
+    while (c < cell->width) {
+      uint8_t alpha = c & 1 ? row[c / 2] & 0x0F : row[c / 2] >> 4;
+      uint8_t index = depth == 1 ? alpha >= 8 : alpha;
+      uint16_t run = 1;
+      while (c + run < cell->width) {
+        uint8_t next = (c + run) & 1 ? row[(c + run) / 2] & 0x0F : row[(c + run) / 2] >> 4;
+        if ((depth == 1 ? next >= 8 : next) != index)
+          break;
+        run++;
+      }
+      canvas->drawFastHLine(x + c, y + r, run, index);
+      c += run;
+    }
+  }
+}
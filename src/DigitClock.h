@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#include "CachedFontRender.h"
+
+// Longest time string supported, "12:34:56 pm" has 11 characters
+#define DIGIT_CLOCK_MAX_CELLS 12
+
+/**
+ * Draws a time string from an atlas of its characters (ASCII, e.g. "0123456789:") rasterized once
+ * at a fixed size and color. Every character is an opaque cell as wide as its advance and as high
+ * as the tallest glyph, hence a changed digit is replaced by pushing just its cell. The alpha
+ * values are kept at 4 bit, about 9 KB for 11 glyphs at 64 px.
+ */
+class DigitClock {
+public:
+  DigitClock(CachedFontRender *font, uint16_t fontSize, const char *glyphs);
+  // Rasterizes the atlas, returns false if a glyph can't be rasterized or out of memory. Calling it
+  // again replaces the atlas.
+  bool begin(TFT_eSPI *tft, uint16_t color, uint16_t background);
+  // Draws all cells of time centered on x like cdrawString() at (x, y). Returns false if time has
+  // characters not in the atlas (nothing is drawn then, and update() fails until the next draw()).
+  // depth 4 or 1: canvas is a palettized sprite, see CachedFontRender::setDrawer().
+  bool draw(TFT_eSPI *canvas, int32_t x, int32_t y, const char *time, uint8_t depth = 16);
+  // Pushes only the cells that differ from what the last draw() or update() at (x, y) left on
+  // canvas. Returns the number of cells pushed, -1 if time can't be drawn that way (different
+  // position or width, unknown characters) and needs a draw() over a cleared background.
+  int8_t update(TFT_eSPI *canvas, int32_t x, int32_t y, const char *time);
+
+private:
+  typedef struct Cell {
+    char c;
+    uint16_t width;
+    // offset of the cell's 4 bit alpha values in _atlas, rows are padded to full bytes
+    uint32_t offset;
+  } Cell;
+
+  CachedFontRender *_font;
+  uint16_t _fontSize;
+  const char *_glyphs;
+  Cell *_cells = nullptr;
+  uint8_t _cellCount = 0;
+  uint8_t *_atlas = nullptr;
+  // cell rows relative to the y passed to draw()
+  int16_t _top = 0;
+  uint16_t _height = 0;
+  // RGB565 per alpha value
+  uint16_t _colors[16];
+  uint16_t *_pixels = nullptr;
+  // what's on the canvas
+  char _drawn[DIGIT_CLOCK_MAX_CELLS + 1] = "";
+  int32_t _drawnX = 0;
+  int32_t _drawnY = 0;
+  bool rasterize(TFT_eSPI *tft, uint16_t color, uint16_t background);
+  // Frees the atlas, nothing can be drawn until the next begin().
+  void release();
+  const Cell *findCell(char c);
+  int32_t layout(const char *time, const Cell **cells);
+  void pushCell(TFT_eSPI *canvas, const Cell *cell, int32_t x, int32_t y);
+  void drawIndexedCell(TFT_eSPI *canvas, const Cell *cell, int32_t x, int32_t y, uint8_t depth);
+};
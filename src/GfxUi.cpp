@@ -5,84 +5,337 @@
 
 #include "GfxUi.h"
 
+#ifdef GFXUI_DMA
+#include <esp_heap_caps.h>
+#endif
+
+#ifdef ICONS_EMBEDDED
+#include "embedded_icon_data.h"
+#endif
+
 #define FS_TP_LOGO "/ThingPulse-logo-260.jpeg"
 
-GfxUi::GfxUi(TFT_eSPI *tft, OpenFontRender *ofr) {
+static size_t readFile(void *context, uint8_t *buf, size_t len) {
+  return ((fs::File *)context)->read(buf, len);
+}
+
+GfxUi::GfxUi(TFT_eSPI *tft, OpenFontRender *ofr) : _iconCache(ICON_CACHE_BYTES) {
   _tft = tft;
+  _canvas = tft;
   _ofr = ofr;
 }
 
-// Bodmer's streamlined x2 faster "no seek" version
+void GfxUi::begin() {
+#ifdef GFXUI_DMA
+  _tft->initDMA();
+#endif
+
+  if (!LittleFS.exists(ATLAS_FILENAME)) {
+    log_i("No icon atlas, drawing icons from individual files.");
+    return;
+  }
+  _atlas = LittleFS.open(ATLAS_FILENAME, "r");
+
+  uint8_t header[ATLAS_HEADER_SIZE];
+  if (_atlas.read(header, sizeof(header)) != sizeof(header) ||
+      memcmp(header, ATLAS_MAGIC, 4) != 0 ||
+      (header[4] | (header[5] << 8)) != ATLAS_VERSION) {
+    log_e("Icon atlas (%s) format not recognized.", ATLAS_FILENAME);
+    _atlas.close();
+    return;
+  }
+
+  uint16_t size = header[6] | (header[7] << 8);
+  _atlasIndex = new AtlasEntry[size];
+  // the index entries are little-endian and packed, exactly like AtlasEntry on the ESP32
+  size_t indexBytes = size * sizeof(AtlasEntry);
+  if (_atlas.read((uint8_t *)_atlasIndex, indexBytes) != indexBytes) {
+    log_e("Icon atlas (%s) is truncated.", ATLAS_FILENAME);
+    delete[] _atlasIndex;
+    _atlasIndex = nullptr;
+    _atlas.close();
+    return;
+  }
+  _atlasSize = size;
+  log_i("Icon atlas with %d icons opened.", _atlasSize);
+}
+
+// Bodmer's streamlined x2 faster "no seek" version, batched into strips of rows
 void GfxUi::drawBmp(String filename, uint16_t x, uint16_t y) {
 
-  if ((x >= _tft->width()) || (y >= _tft->height()))
+  if ((x >= _canvas->width()) || (y >= _canvas->height()))
     return;
 
-  fs::File bmpFS;
+  uint32_t pushesBefore = _pushCount;
+  uint32_t id = iconId(filename);
+  const BmpHeaderCacheEntry *header = findBmpHeader(id);
 
   // Note: ESP32 passes "open" test even if file does not exist, whereas ESP8266
-  // returns NULL
-  if (!LittleFS.exists(filename)) {
-    log_e(" File (%s) not found", filename);
+  // returns NULL. A cached header proves the file exists, which saves a directory lookup.
+  if (!header && !LittleFS.exists(filename)) {
+    log_e(" File (%s) not found", filename.c_str());
     return;
   }
 
   // Open requested file
-  bmpFS = LittleFS.open(filename, "r");
-
-  uint32_t seekOffset;
-  uint16_t w, h, row;
-  uint8_t r, g, b;
-  bool oldSwap = false;
-
-  if (read16(bmpFS) == 0x4D42) {
-    read32(bmpFS);
-    read32(bmpFS);
-    seekOffset = read32(bmpFS);
-    read32(bmpFS);
-    w = read32(bmpFS);
-    h = read32(bmpFS);
-
-    if ((read16(bmpFS) == 1) && (read16(bmpFS) == 24) && (read32(bmpFS) == 0)) {
-      y += h - 1;
-
-      oldSwap = _tft->getSwapBytes();
-      _tft->setSwapBytes(true);
-      bmpFS.seek(seekOffset);
-
-      // Calculate padding to avoid seek
-      uint16_t padding = (4 - ((w * 3) & 3)) & 3;
-      uint8_t lineBuffer[w * 3 + padding];
-
-      for (row = 0; row < h; row++) {
-
-        bmpFS.read(lineBuffer, sizeof(lineBuffer));
-        uint8_t *bptr = lineBuffer;
-        uint16_t *tptr = (uint16_t *)lineBuffer;
-        // Convert 24 to 16 bit colours using the same line buffer for results
-        for (uint16_t col = 0; col < w; col++) {
-          b = *bptr++;
-          g = *bptr++;
-          r = *bptr++;
-          *tptr++ = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-        }
-
-        // Push the pixel row to screen, pushImage will crop the line if needed
-        // y is decremented as the BMP image is drawn bottom up
-        _tft->pushImage(x, y--, w, 1, (uint16_t *)lineBuffer);
-      }
-    } else
-      log_e("BMP (%s) format not recognized.", filename);
+  fs::File bmpFS = LittleFS.open(filename, "r");
+  if (!header) {
+    header = readBmpHeader(bmpFS, id);
+    if (!header) {
+      log_e("BMP (%s) format not recognized.", filename.c_str());
+      bmpFS.close();
+      return;
+    }
+  }
+
+  const BmpInfo &info = header->info;
+  uint16_t w = info.width;
+  uint16_t h = info.height;
+  uint16_t stripRows = beginStrips(w);
+  if (stripRows == 0) {
+    bmpFS.close();
+    return;
   }
-  _tft->setSwapBytes(oldSwap);
+  bool oldSwap = _canvas->getSwapBytes();
+  _canvas->setSwapBytes(true);
+  bmpFS.seek(info.pixelOffset);
+
+  // Rows are read including their padding to avoid seeks
+  uint8_t lineBuffer[info.stride];
+
+  // Bottom-up BMPs fill the strips from their last row upwards and push them from the bottom of
+  // the image to the top, top-down BMPs the other way round.
+  uint16_t rowsDone = 0;
+  while (rowsDone < h) {
+    uint16_t rows = h - rowsDone < stripRows ? h - rowsDone : stripRows;
+    uint16_t *strip = nextStrip();
+    for (uint16_t i = 0; i < rows; i++) {
+      bmpFS.read(lineBuffer, info.stride);
+      convertBmpRow(lineBuffer, strip + (info.topDown ? i : rows - 1 - i) * w, info,
+                    header->palette);
+    }
+    rowsDone += rows;
+    // Push the strip as one window, it's cropped if needed
+    pushStrip(x, y + (info.topDown ? rowsDone - rows : h - rowsDone), w, rows, strip);
+  }
+  endStrips();
+  _canvas->setSwapBytes(oldSwap);
+
   bmpFS.close();
+  _lastIconPushes = _pushCount - pushesBefore;
+}
+
+const GfxUi::BmpHeaderCacheEntry *GfxUi::findBmpHeader(uint32_t id) {
+  for (const BmpHeaderCacheEntry &entry : _bmpHeaders) {
+    if (entry.valid && entry.id == id)
+      return &entry;
+  }
+  return nullptr;
+}
+
+// Parses the header with a single read (plus one for the palette of 8 bit images) and caches it,
+// later draws of the same file skip the header entirely.
+const GfxUi::BmpHeaderCacheEntry *GfxUi::readBmpHeader(fs::File &f, uint32_t id) {
+  uint8_t buf[BMP_HEADER_READ_SIZE];
+  BmpInfo info;
+  if (!parseBmpHeader(buf, f.read(buf, sizeof(buf)), &info))
+    return nullptr;
+
+  uint16_t *palette = nullptr;
+  if (info.paletteSize) {
+    size_t bytes = info.paletteSize * 4;
+    uint8_t *raw = (uint8_t *)malloc(bytes);
+    if (!raw)
+      return nullptr;
+    f.seek(info.paletteOffset);
+    if (f.read(raw, bytes) != bytes) {
+      free(raw);
+      return nullptr;
+    }
+    convertBmpPalette(raw, info.paletteSize);
+    // indices beyond the palette of a corrupt file must not read out of bounds
+    palette = (uint16_t *)realloc(raw, BMP_MAX_PALETTE_SIZE * sizeof(uint16_t));
+    if (!palette) {
+      free(raw);
+      return nullptr;
+    }
+    memset(palette + info.paletteSize, 0,
+           (BMP_MAX_PALETTE_SIZE - info.paletteSize) * sizeof(uint16_t));
+  }
+
+  // round robin, the table is sized for all BMPs drawn regularly
+  BmpHeaderCacheEntry &entry = _bmpHeaders[_nextBmpHeader];
+  _nextBmpHeader = (_nextBmpHeader + 1) % BMP_HEADER_CACHE_ENTRIES;
+  free(entry.palette);
+  entry = {id, true, info, palette};
+  return &entry;
+}
+
+void GfxUi::drawIcon(String name, uint16_t x, uint16_t y) {
+  if ((x >= _canvas->width()) || (y >= _canvas->height()))
+    return;
+
+  uint32_t pushesBefore = _pushCount;
+  drawIconFromBestSource(name, x, y);
+  _lastIconPushes = _pushCount - pushesBefore;
+  log_d("Icon %s drawn with %d pushes.", name.c_str(), _lastIconPushes);
+}
+
+void GfxUi::drawIconFromBestSource(const String &name, uint16_t x, uint16_t y) {
+  uint32_t id = iconId(name);
+#ifdef ICONS_EMBEDDED
+  if (drawEmbeddedIcon(id, x, y))
+    return;
+#endif
+
+  uint16_t w, h;
+  const uint16_t *pixels = _iconCache.get(id, &w, &h);
+  if (pixels) {
+    pushRgb565(x, y, w, h, pixels);
+    return;
+  }
+
+  const AtlasEntry *entry = findAtlasEntry(id);
+  if (entry) {
+    _atlas.seek(entry->offset);
+    if (entry->format == ATLAS_FORMAT_PRLE) {
+      drawPrle(_atlas, id, x, y);
+    } else {
+      drawRgb565Pixels(_atlas, id, x, y, entry->width, entry->height);
+    }
+    return;
+  }
+
+  String filename = name + RGB565_EXTENSION;
+  if (LittleFS.exists(filename)) {
+    fs::File iconFS = LittleFS.open(filename, "r");
+    if (readRgb565Header(iconFS, &w, &h)) {
+      drawRgb565Pixels(iconFS, id, x, y, w, h);
+    } else {
+      log_e("RGB565 (%s) format not recognized.", filename.c_str());
+    }
+    iconFS.close();
+    return;
+  }
+
+  filename = name + PRLE_EXTENSION;
+  if (LittleFS.exists(filename)) {
+    fs::File iconFS = LittleFS.open(filename, "r");
+    uint8_t magic[4];
+    if (iconFS.read(magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, PRLE_MAGIC, 4) == 0) {
+      drawPrle(iconFS, id, x, y);
+    } else {
+      log_e("PRLE (%s) format not recognized.", filename.c_str());
+    }
+    iconFS.close();
+    return;
+  }
+
+  // not cached, BMPs are read from flash on every repaint until tools/icons.py converts them
+  drawBmp(name + ".bmp", x, y);
+}
+
+// The pixels are stored exactly as they go over the wire, hence no per-pixel work is needed.
+void GfxUi::drawRgb565(String filename, uint16_t x, uint16_t y) {
+
+  if ((x >= _canvas->width()) || (y >= _canvas->height()))
+    return;
+
+  fs::File iconFS = LittleFS.open(filename, "r");
+  if (!iconFS) {
+    log_e(" File (%s) not found", filename.c_str());
+    return;
+  }
+
+  uint32_t pushesBefore = _pushCount;
+  uint16_t w, h;
+  if (readRgb565Header(iconFS, &w, &h)) {
+    pushRgb565Rows(iconFS, x, y, w, h);
+  } else {
+    log_e("RGB565 (%s) format not recognized.", filename.c_str());
+  }
+  iconFS.close();
+  _lastIconPushes = _pushCount - pushesBefore;
+}
+
+#ifdef ICONS_EMBEDDED
+void GfxUi::drawIcon(EmbeddedIcon icon, uint16_t x, uint16_t y) {
+  if ((x >= _canvas->width()) || (y >= _canvas->height()) || icon >= EmbeddedIcon::COUNT)
+    return;
+
+  uint32_t pushesBefore = _pushCount;
+  const EmbeddedIconInfo &info = EMBEDDED_ICONS[(uint16_t)icon];
+  // flash is memory-mapped, the pixels are sent straight from there
+  pushRgb565(x, y, info.width, info.height, info.pixels);
+  _lastIconPushes = _pushCount - pushesBefore;
+}
+
+bool GfxUi::drawEmbeddedIcon(uint32_t id, uint16_t x, uint16_t y) {
+  for (uint16_t i = 0; i < (uint16_t)EmbeddedIcon::COUNT; i++) {
+    if (EMBEDDED_ICONS[i].id == id) {
+      pushRgb565(x, y, EMBEDDED_ICONS[i].width, EMBEDDED_ICONS[i].height, EMBEDDED_ICONS[i].pixels);
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+void GfxUi::drawMoon(uint16_t x, uint16_t y, uint16_t diameter, double illumination, bool waxing,
+                     bool southernHemisphere, bool antiAliased) {
+  if ((x >= _canvas->width()) || (y >= _canvas->height()) || diameter == 0)
+    return;
+
+  uint32_t pushesBefore = _pushCount;
+  uint16_t stripRows = beginStrips(diameter);
+  if (stripRows == 0)
+    return;
+  MoonRenderer moon(diameter, illumination, waxing, southernHemisphere, antiAliased);
+  bool oldSwap = _canvas->getSwapBytes();
+  _canvas->setSwapBytes(true);
+
+  for (uint16_t row = 0; row < diameter; row += stripRows) {
+    uint16_t rows = diameter - row < stripRows ? diameter - row : stripRows;
+    uint16_t *strip = nextStrip();
+    moon.renderRows(strip, row, rows);
+    pushStrip(x, y + row, diameter, rows, strip);
+  }
+  endStrips();
+
+  _canvas->setSwapBytes(oldSwap);
+  _lastIconPushes = _pushCount - pushesBefore;
+}
+
+void GfxUi::setCanvas(TFT_eSPI *canvas) {
+  _canvas = canvas ? canvas : _tft;
+}
+
+IconCacheStats GfxUi::getIconCacheStats() {
+  return _iconCache.getStats();
+}
+
+void GfxUi::clearIconCache() {
+  _iconCache.clear();
+}
+
+uint32_t GfxUi::getPushCount() {
+  return _pushCount;
+}
+
+uint16_t GfxUi::getLastIconPushCount() {
+  return _lastIconPushes;
 }
 
 void GfxUi::drawLogo() {
   if (LittleFS.exists(FS_TP_LOGO)) {
     uint16_t w = 0, h = 0;
     TJpgDec.getFsJpgSize(&w, &h, FS_TP_LOGO, LittleFS);
-    TJpgDec.drawFsJpg((_tft->width() - w) / 2, 30, FS_TP_LOGO, LittleFS);
+    // the decoder calls pushJpegBlock() (through the callback set in main.cpp) for every block of
+    // at most 16x16 px, without the strip buffers they're pushed synchronously
+    beginStrips(16);
+    TJpgDec.drawFsJpg((_canvas->width() - w) / 2, 30, FS_TP_LOGO, LittleFS);
+    endStrips();
   }
 }
 
@@ -90,32 +343,253 @@ void GfxUi::drawProgressBar(uint16_t x0, uint16_t y0, uint16_t w, uint16_t h,
                             uint8_t percentage, uint16_t frameColor,
                             uint16_t barColor) {
   if (percentage == 0) {
-    _tft->fillRoundRect(x0, y0, w, h, 3, TFT_BLACK);
+    _canvas->fillRoundRect(x0, y0, w, h, 3, TFT_BLACK);
   }
   uint8_t margin = 2;
   uint16_t barHeight = h - 2 * margin;
   uint16_t barWidth = w - 2 * margin;
-  _tft->drawRoundRect(x0, y0, w, h, 3, frameColor);
-  _tft->fillRect(x0 + margin, y0 + margin, barWidth * percentage / 100.0,
+  _canvas->drawRoundRect(x0, y0, w, h, 3, frameColor);
+  _canvas->fillRect(x0 + margin, y0 + margin, barWidth * percentage / 100.0,
                  barHeight, barColor);
 }
 
-// These read 16- and 32-bit types from the SD card file.
-// BMP data is stored little-endian, Arduino is little-endian too.
-// May need to reverse subscript order if porting elsewhere.
+// 32-bit FNV-1a, identical to icon_id() in tools/icons.py
+uint32_t GfxUi::iconId(const String &name) {
+  uint32_t id = 0x811C9DC5;
+  for (const char *c = name.c_str(); *c; c++) {
+    id = (id ^ (uint8_t)*c) * 0x01000193;
+  }
+  return id;
+}
+
+// Binary search as the atlas index is sorted by icon ID.
+const AtlasEntry *GfxUi::findAtlasEntry(uint32_t id) {
+  if (_atlasSize == 0)
+    return nullptr;
+
+  int lo = 0, hi = _atlasSize - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (_atlasIndex[mid].id == id)
+      return &_atlasIndex[mid];
+    if (_atlasIndex[mid].id < id)
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+  }
+  return nullptr;
+}
+
+bool GfxUi::readRgb565Header(fs::File &f, uint16_t *w, uint16_t *h) {
+  uint8_t header[RGB565_HEADER_SIZE];
+  if (f.read(header, sizeof(header)) != sizeof(header) || memcmp(header, RGB565_MAGIC, 4) != 0)
+    return false;
+  *w = header[4] | (header[5] << 8);
+  *h = header[6] | (header[7] << 8);
+  return true;
+}
+
+// Reads the icon into the cache and draws it from there, streams it if it doesn't fit the cache.
+void GfxUi::drawRgb565Pixels(fs::File &f, uint32_t id, uint16_t x, uint16_t y, uint16_t w,
+                             uint16_t h) {
+  uint16_t *pixels = _iconCache.put(id, w, h);
+  if (!pixels) {
+    pushRgb565Rows(f, x, y, w, h);
+    return;
+  }
+
+  size_t bytes = w * h * sizeof(uint16_t);
+  if (f.read((uint8_t *)pixels, bytes) != bytes) {
+    log_e("RGB565 pixel data is truncated.");
+    _iconCache.remove(id);
+    return;
+  }
+  pushRgb565(x, y, w, h, pixels);
+}
+
+// Decodes row by row into the cache, or straight to the screen if the icon doesn't fit the cache.
+void GfxUi::drawPrle(fs::File &f, uint32_t id, uint16_t x, uint16_t y) {
+  PaletteRleDecoder decoder(readFile, &f);
+  if (!decoder.begin()) {
+    log_e("PRLE header not recognized.");
+    return;
+  }
+  uint16_t w = decoder.width();
+  uint16_t h = decoder.height();
+
+  uint16_t *pixels = _iconCache.put(id, w, h);
+  if (pixels) {
+    for (uint16_t row = 0; row < h; row++) {
+      if (!decoder.readRow(pixels + row * w)) {
+        log_e("PRLE data is corrupt.");
+        _iconCache.remove(id);
+        return;
+      }
+    }
+    pushRgb565(x, y, w, h, pixels);
+    return;
+  }
 
-uint16_t GfxUi::read16(fs::File &f) {
-  uint16_t result;
-  ((uint8_t *)&result)[0] = f.read(); // LSB
-  ((uint8_t *)&result)[1] = f.read(); // MSB
-  return result;
+  uint16_t stripRows = beginStrips(w);
+  if (stripRows == 0)
+    return;
+  bool oldSwap = _canvas->getSwapBytes();
+  _canvas->setSwapBytes(false);
+  for (uint16_t row = 0; row < h; row += stripRows) {
+    uint16_t rows = h - row < stripRows ? h - row : stripRows;
+    uint16_t *strip = nextStrip();
+    bool ok = true;
+    for (uint16_t i = 0; ok && i < rows; i++) {
+      ok = decoder.readRow(strip + i * w);
+    }
+    if (!ok) {
+      log_e("PRLE data is corrupt.");
+      break;
+    }
+    pushStrip(x, y + row, w, rows, strip);
+  }
+  endStrips();
+  _canvas->setSwapBytes(oldSwap);
+}
+
+void GfxUi::pushRgb565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels) {
+  bool oldSwap = _canvas->getSwapBytes();
+  _canvas->setSwapBytes(false);
+  // the pixels are in RAM, the const overload of pushImage() is meant for (slower) PROGMEM data
+  pushImage(x, y, w, h, const_cast<uint16_t *>(pixels));
+  _canvas->setSwapBytes(oldSwap);
+}
+
+// Streams w x h pre-swapped RGB565 pixels from the current position of f to the screen.
+void GfxUi::pushRgb565Rows(fs::File &f, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  uint16_t stripRows = beginStrips(w);
+  if (stripRows == 0)
+    return;
+  bool oldSwap = _canvas->getSwapBytes();
+  _canvas->setSwapBytes(false);
+
+  for (uint16_t row = 0; row < h; row += stripRows) {
+    uint16_t rows = h - row < stripRows ? h - row : stripRows;
+    uint16_t *strip = nextStrip();
+    size_t bytes = w * rows * sizeof(uint16_t);
+    if (f.read((uint8_t *)strip, bytes) != bytes) {
+      log_e("RGB565 pixel data is truncated.");
+      break;
+    }
+    // the strip is cropped if needed
+    pushStrip(x, y + row, w, rows, strip);
+  }
+  endStrips();
+
+  _canvas->setSwapBytes(oldSwap);
+}
+
+// Strip pipeline: with DMA the strips alternate between two buffers. While one is being sent to
+// the display the next one is read and decoded into the other. pushImageDMA() waits for the
+// previous transfer to complete before it starts the next one, hence once it returns the buffer
+// sent before is free again. Without DMA a single buffer is pushed synchronously, and without
+// memory for that an image is drawn a row at a time from a buffer taken just for it.
+uint16_t GfxUi::beginStrips(uint16_t w) {
+  if (w == 0 || w > STRIP_BUFFER_PIXELS) {
+    log_e("Can't draw a %u px wide image, a strip holds %u pixels.", w, STRIP_BUFFER_PIXELS);
+    return 0;
+  }
+  if (_stripCount == 0)
+    allocateStrips();
+  if (_stripCount == 0) {
+    _row = (uint16_t *)malloc(w * sizeof(uint16_t));
+    if (!_row) {
+      log_e("Not enough memory for a %u px row.", w);
+      return 0;
+    }
+  }
+#ifdef GFXUI_DMA
+  if (dmaStrips())
+    _tft->startWrite();
+#endif
+  return _row ? 1 : STRIP_BUFFER_PIXELS / w;
+}
+
+void GfxUi::allocateStrips() {
+  // allocated on first use and kept, needed for every image that isn't drawn from the cache
+#ifdef GFXUI_DMA
+  for (uint8_t i = 0; i < STRIP_BUFFERS; i++) {
+    _strips[i] = (uint16_t *)heap_caps_malloc(STRIP_BUFFER_PIXELS * sizeof(uint16_t),
+                                              MALLOC_CAP_DMA);
+  }
+  if (_strips[0] && _strips[1]) {
+    _stripCount = STRIP_BUFFERS;
+    return;
+  }
+  for (uint8_t i = 0; i < STRIP_BUFFERS; i++) {
+    free(_strips[i]);
+    _strips[i] = nullptr;
+  }
+  log_w("Not enough DMA memory for the strip buffers, pushing strips synchronously.");
+#endif
+  _strips[0] = (uint16_t *)malloc(STRIP_BUFFER_PIXELS * sizeof(uint16_t));
+  if (_strips[0])
+    _stripCount = 1;
+  else
+    log_w("Not enough memory for a strip buffer, drawing images row by row.");
+}
+
+uint16_t *GfxUi::nextStrip() {
+  if (_row)
+    return _row;
+  _stripIndex = (_stripIndex + 1) % _stripCount;
+  return _strips[_stripIndex];
+}
+
+void GfxUi::pushStrip(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *strip) {
+#ifdef GFXUI_DMA
+  // sprites are drawn into synchronously
+  if (dmaStrips()) {
+    _pushCount++;
+    _tft->pushImageDMA(x, y, w, h, strip);
+    return;
+  }
+#endif
+  pushImage(x, y, w, h, strip);
+}
+
+void GfxUi::endStrips() {
+#ifdef GFXUI_DMA
+  if (dmaStrips()) {
+    _tft->dmaWait();
+    _tft->endWrite();
+  }
+#endif
+  free(_row);
+  _row = nullptr;
+}
+
+#ifdef GFXUI_DMA
+bool GfxUi::dmaStrips() {
+  return _canvas == _tft && _stripCount == STRIP_BUFFERS;
+}
+#endif
+
+bool GfxUi::pushJpegBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
+  // Stop further decoding as image is running off bottom of screen
+  if (y >= _canvas->height()) {
+    return false;
+  }
+#ifdef GFXUI_DMA
+  if (dmaStrips()) {
+    // the decoder reuses bitmap for the next block, hence the block is copied into the strip
+    // buffer (which is always large enough for an MCU block) and sent from there
+    _pushCount++;
+    _tft->pushImageDMA(x, y, w, h, bitmap, nextStrip());
+    return true;
+  }
+#endif
+  // Automatically clips the image block rendering at the TFT boundaries.
+  pushImage(x, y, w, h, bitmap);
+  return true;
 }
 
-uint32_t GfxUi::read32(fs::File &f) {
-  uint32_t result;
-  ((uint8_t *)&result)[0] = f.read(); // LSB
-  ((uint8_t *)&result)[1] = f.read();
-  ((uint8_t *)&result)[2] = f.read();
-  ((uint8_t *)&result)[3] = f.read(); // MSB
-  return result;
+void GfxUi::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) {
+  _pushCount++;
+  _canvas->pushImage(x, y, w, h, data);
 }
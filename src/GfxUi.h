@@ -13,23 +13,138 @@
 // JPEG decoder library
 #include <TJpg_Decoder.h>
 
+#include "BmpHeader.h"
+#include "IconCache.h"
+#include "MoonRenderer.h"
+#include "PaletteRle.h"
+
+// -D ICONS_EMBEDDED compiles the icons into the firmware (generated by tools/pio_embed_icons.py)
+// instead of reading them from LittleFS.
+#ifdef ICONS_EMBEDDED
+#include "embedded_icons.h"
+#endif
+
 // Maximum of 85 for BUFFPIXEL as 3 x this value is stored in an 8 bit variable!
 // 32 is an efficient size for LittleFS due to SPI hardware pipeline buffer size
 // A larger value of 80 is better for SD cards
 #define BUFFPIXEL 32
 
+// Icons are decoded into strips of up to this many pixels which are pushed as one window each,
+// i.e. 27 rows of a 75 px wide icon rather than 27 single-row transfers.
+#define STRIP_BUFFER_PIXELS (BUFFPIXEL * 64)
+
+// Stream images with DMA where TFT_eSPI supports it, -D GFXUI_DISABLE_DMA turns it off.
+#if defined(ESP32_DMA) && !defined(GFXUI_DISABLE_DMA)
+  #define GFXUI_DMA
+  #define STRIP_BUFFERS 2
+#else
+  #define STRIP_BUFFERS 1
+#endif
+
+// Raw RGB565 icons as generated by tools/icons.py: 8 byte header (magic, width, height, the latter
+// two little-endian) followed by big-endian ("pre-swapped") pixels in top-down row order.
+#define RGB565_MAGIC "R565"
+#define RGB565_HEADER_SIZE 8
+#define RGB565_EXTENSION ".565"
+
+// All icons in one file with an index, see write_atlas() in tools/icons.py for the layout.
+#define ATLAS_FILENAME "/icons.atlas"
+#define ATLAS_MAGIC "ICAT"
+#define ATLAS_VERSION 2
+#define ATLAS_HEADER_SIZE 8
+#define ATLAS_FORMAT_RGB565 0
+#define ATLAS_FORMAT_PRLE 1
+
+// Parsed BMP headers (and palettes) are kept for this many files
+#define BMP_HEADER_CACHE_ENTRIES 8
+
+typedef struct AtlasEntry {
+  uint32_t id;
+  uint32_t offset;
+  uint16_t width;
+  uint16_t height;
+  uint8_t format;
+  uint8_t reserved[3];
+} AtlasEntry;
+
 class GfxUi {
 public:
   GfxUi(TFT_eSPI *tft, OpenFontRender *render);
+  // Initializes DMA and opens the icon atlas (if present), call once after the display is
+  // initialized and the file system is mounted.
+  void begin();
   void drawBmp(String filename, uint16_t x, uint16_t y);
+  // Draws the icon 'name' (path without extension, e.g. "/wind/N") from the best format available.
+  void drawIcon(String name, uint16_t x, uint16_t y);
+  void drawRgb565(String filename, uint16_t x, uint16_t y);
+#ifdef ICONS_EMBEDDED
+  void drawIcon(EmbeddedIcon icon, uint16_t x, uint16_t y);
+#endif
+  // Renders the moon disc for the given illumination (0..1), see MoonRenderer.
+  void drawMoon(uint16_t x, uint16_t y, uint16_t diameter, double illumination, bool waxing,
+                bool southernHemisphere, bool antiAliased);
+  // Draws into canvas (e.g. an off-screen sprite) instead of the display, nullptr switches back.
+  void setCanvas(TFT_eSPI *canvas);
+  IconCacheStats getIconCacheStats();
+  void clearIconCache();
+  // Number of pushImage() calls, i.e. SPI transactions, in total and for the last icon drawn
+  uint32_t getPushCount();
+  uint16_t getLastIconPushCount();
   void drawLogo();
+  // TJpg_Decoder output callback, needs to be wrapped in a plain function for TJpgDec.setCallback()
+  bool pushJpegBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
   void drawProgressBar(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
                        uint8_t percentage, uint16_t frameColor,
                        uint16_t barColor);
 
 private:
+  typedef struct BmpHeaderCacheEntry {
+    uint32_t id;
+    bool valid;
+    BmpInfo info;
+    // RGB565, 8 bit images only
+    uint16_t *palette;
+  } BmpHeaderCacheEntry;
+
   TFT_eSPI *_tft;
+  TFT_eSPI *_canvas;
   OpenFontRender *_ofr;
-  uint16_t read16(fs::File &f);
-  uint32_t read32(fs::File &f);
+  fs::File _atlas;
+  AtlasEntry *_atlasIndex = nullptr;
+  uint16_t _atlasSize = 0;
+  IconCache _iconCache;
+  BmpHeaderCacheEntry _bmpHeaders[BMP_HEADER_CACHE_ENTRIES] = {};
+  uint8_t _nextBmpHeader = 0;
+  uint16_t *_strips[STRIP_BUFFERS] = {};
+  uint8_t _stripCount = 0;
+  uint8_t _stripIndex = 0;
+  // the one row drawn at a time if there was no memory for a strip buffer
+  uint16_t *_row = nullptr;
+  uint32_t _pushCount = 0;
+  uint16_t _lastIconPushes = 0;
+  void drawIconFromBestSource(const String &name, uint16_t x, uint16_t y);
+#ifdef ICONS_EMBEDDED
+  bool drawEmbeddedIcon(uint32_t id, uint16_t x, uint16_t y);
+#endif
+  uint32_t iconId(const String &name);
+  const AtlasEntry *findAtlasEntry(uint32_t id);
+  const BmpHeaderCacheEntry *findBmpHeader(uint32_t id);
+  const BmpHeaderCacheEntry *readBmpHeader(fs::File &f, uint32_t id);
+  bool readRgb565Header(fs::File &f, uint16_t *w, uint16_t *h);
+  void drawRgb565Pixels(fs::File &f, uint32_t id, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  void drawPrle(fs::File &f, uint32_t id, uint16_t x, uint16_t y);
+  void pushRgb565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+  void pushRgb565Rows(fs::File &f, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  // Gets the strips ready for an image w px wide and returns how many of its rows go into one, 0 if
+  // it's wider than a strip or there's no memory for even one row.
+  uint16_t beginStrips(uint16_t w);
+  void allocateStrips();
+  uint16_t *nextStrip();
+  void pushStrip(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *strip);
+  void endStrips();
+#ifdef GFXUI_DMA
+  // whether the strips go out by DMA, i.e. both buffers are there and they're pushed to the display
+  bool dmaStrips();
+#endif
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
 };
@@ -0,0 +1,160 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "GlyphCache.h"
+
+GlyphCache::GlyphCache(size_t budget) {
+  _slabCount = budget / GLYPH_SLAB_BYTES;
+  if (_slabCount > GLYPH_MAX_SLABS)
+    _slabCount = GLYPH_MAX_SLABS;
+  _stats.bytesBudget = _slabCount * GLYPH_SLAB_BYTES;
+  memset(_slabClass, GLYPH_SIZE_CLASSES, sizeof(_slabClass));
+}
+
+const Glyph *GlyphCache::get(uint32_t fontId, uint16_t fontSize, uint32_t codepoint) {
+  for (Entry &entry : _entries) {
+    if (entry.used && entry.glyph.codepoint == codepoint && entry.glyph.fontSize == fontSize &&
+        entry.glyph.fontId == fontId) {
+      entry.lastUsed = ++_clock;
+      _stats.hits++;
+      return &entry.glyph;
+    }
+  }
+  _stats.misses++;
+  return nullptr;
+}
+
+Glyph *GlyphCache::put(uint32_t fontId, uint16_t fontSize, uint32_t codepoint, uint16_t w,
+                       uint16_t h) {
+  size_t bytes = w * h;
+  uint8_t sizeClass = GLYPH_SIZE_CLASSES;
+  if (bytes > 0) {
+    sizeClass = 0;
+    while (sizeClass < GLYPH_SIZE_CLASSES && classBytes(sizeClass) < bytes) {
+      sizeClass++;
+    }
+    if (sizeClass == GLYPH_SIZE_CLASSES) {
+      _stats.uncacheable++;
+      return nullptr;
+    }
+  }
+
+  if (!_arena && _slabCount > 0) {
+    // allocated on first use and kept until freeArena(), the budget is fixed
+#ifdef BOARD_HAS_PSRAM
+    _arena = (uint8_t *)ps_malloc(_slabCount * GLYPH_SLAB_BYTES);
+#else
+    _arena = (uint8_t *)malloc(_slabCount * GLYPH_SLAB_BYTES);
+#endif
+    if (!_arena) {
+      log_w("Failed to allocate %d bytes for the glyph cache.", _slabCount * GLYPH_SLAB_BYTES);
+      _slabCount = 0;
+    }
+  }
+
+  // make room: a free entry and, for glyphs with ink, an object of the size class
+  Entry *slot = nullptr;
+  uint8_t *mask = nullptr;
+  while (true) {
+    if (!slot) {
+      for (Entry &entry : _entries) {
+        if (!entry.used) {
+          slot = &entry;
+          break;
+        }
+      }
+    }
+    if (!mask && sizeClass < GLYPH_SIZE_CLASSES)
+      mask = allocate(sizeClass);
+    if (slot && (mask || sizeClass == GLYPH_SIZE_CLASSES))
+      break;
+    Entry *victim = leastRecentlyUsed();
+    if (!victim) {
+      if (mask)
+        release(mask, sizeClass);
+      return nullptr;
+    }
+    evict(victim);
+    _stats.evictions++;
+  }
+
+  slot->used = true;
+  slot->lastUsed = ++_clock;
+  slot->sizeClass = sizeClass;
+  slot->glyph = {fontId, codepoint, fontSize, 0, 0, w, h, 0, mask};
+  _stats.entries++;
+  if (mask)
+    _stats.bytesUsed += classBytes(sizeClass);
+  return &slot->glyph;
+}
+
+void GlyphCache::clear() {
+  for (Entry &entry : _entries) {
+    if (entry.used) {
+      evict(&entry);
+    }
+  }
+}
+
+void GlyphCache::freeArena() {
+  clear();
+  free(_arena);
+  _arena = nullptr;
+}
+
+GlyphCacheStats GlyphCache::getStats() {
+  return _stats;
+}
+
+// Takes a free object from a slab of the size class, or claims a free slab for the class.
+uint8_t *GlyphCache::allocate(uint8_t sizeClass) {
+  uint16_t perSlab = GLYPH_SLAB_BYTES / classBytes(sizeClass);
+  uint64_t full = perSlab == 64 ? ~0ULL : (1ULL << perSlab) - 1;
+  int16_t freeSlab = -1;
+  for (uint16_t slab = 0; slab < _slabCount; slab++) {
+    if (_slabClass[slab] == sizeClass && _slabUsed[slab] != full) {
+      uint8_t index = 0;
+      while (_slabUsed[slab] & (1ULL << index)) {
+        index++;
+      }
+      _slabUsed[slab] |= 1ULL << index;
+      return _arena + slab * GLYPH_SLAB_BYTES + index * classBytes(sizeClass);
+    }
+    if (freeSlab < 0 && _slabClass[slab] == GLYPH_SIZE_CLASSES)
+      freeSlab = slab;
+  }
+  if (freeSlab < 0)
+    return nullptr;
+  _slabClass[freeSlab] = sizeClass;
+  _slabUsed[freeSlab] = 1;
+  return _arena + freeSlab * GLYPH_SLAB_BYTES;
+}
+
+// Empty slabs go back to the pool, any size class can claim them then.
+void GlyphCache::release(uint8_t *mask, uint8_t sizeClass) {
+  size_t offset = mask - _arena;
+  uint16_t slab = offset / GLYPH_SLAB_BYTES;
+  uint8_t index = (offset % GLYPH_SLAB_BYTES) / classBytes(sizeClass);
+  _slabUsed[slab] &= ~(1ULL << index);
+  if (_slabUsed[slab] == 0)
+    _slabClass[slab] = GLYPH_SIZE_CLASSES;
+}
+
+void GlyphCache::evict(Entry *entry) {
+  if (entry->glyph.alpha) {
+    release(entry->glyph.alpha, entry->sizeClass);
+    _stats.bytesUsed -= classBytes(entry->sizeClass);
+  }
+  _stats.entries--;
+  *entry = {};
+}
+
+GlyphCache::Entry *GlyphCache::leastRecentlyUsed() {
+  Entry *result = nullptr;
+  for (Entry &entry : _entries) {
+    if (entry.used && (!result || entry.lastUsed < result->lastUsed)) {
+      result = &entry;
+    }
+  }
+  return result;
+}
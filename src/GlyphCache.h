@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+
+// Byte budget for glyph alpha masks, override with -D GLYPH_CACHE_BYTES=... in platformio.ini.
+// The clock digits alone take about 20 KB at 64 px.
+#ifndef GLYPH_CACHE_BYTES
+  #ifdef BOARD_HAS_PSRAM
+    #define GLYPH_CACHE_BYTES (128 * 1024)
+  #else
+    #define GLYPH_CACHE_BYTES (40 * 1024)
+  #endif
+#endif
+
+#ifndef GLYPH_CACHE_MAX_ENTRIES
+  #define GLYPH_CACHE_MAX_ENTRIES 192
+#endif
+
+// The budget is split into slabs of this size, each slab holds masks of one size class (powers of
+// two from GLYPH_MIN_CLASS_BYTES up to the slab size). Masks larger than a slab aren't cached.
+#define GLYPH_SLAB_BYTES 4096
+#define GLYPH_MIN_CLASS_BYTES 64
+#define GLYPH_SIZE_CLASSES 7
+#define GLYPH_MAX_SLABS (GLYPH_CACHE_BYTES / GLYPH_SLAB_BYTES)
+
+typedef struct GlyphCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  // glyphs too large for a slab, drawn without the cache
+  uint32_t uncacheable;
+  uint16_t entries;
+  // bytes of the size classes handed out, i.e. including the rounding up to the class size
+  size_t bytesUsed;
+  size_t bytesBudget;
+} GlyphCacheStats;
+
+// A rasterized glyph. left/top locate the mask relative to where the glyph's string is drawn.
+typedef struct Glyph {
+  uint32_t fontId;
+  uint32_t codepoint;
+  uint16_t fontSize;
+  int16_t left;
+  int16_t top;
+  uint16_t width;
+  uint16_t height;
+  int16_t advance;
+  // width x height 8 bit alpha values, nullptr for glyphs without ink (e.g. space)
+  uint8_t *alpha;
+} Glyph;
+
+/**
+ * Anti-aliased glyph masks keyed by (font, pixel size, codepoint) in a fixed arena. A slab
+ * allocator avoids heap fragmentation from many small, differently sized masks. The least recently
+ * used glyphs are evicted when an entry or slab space is needed.
+ */
+class GlyphCache {
+public:
+  GlyphCache(size_t budget);
+  // Returns the cached glyph or nullptr on a miss (which is counted as such).
+  const Glyph *get(uint32_t fontId, uint16_t fontSize, uint32_t codepoint);
+  // Returns an entry with room for w x h alpha values the caller has to fill in (metrics and
+  // mask), nullptr if it can't be cached.
+  Glyph *put(uint32_t fontId, uint16_t fontSize, uint32_t codepoint, uint16_t w, uint16_t h);
+  void clear();
+  // Evicts every glyph and frees the arena, the next put() allocates it again.
+  void freeArena();
+  GlyphCacheStats getStats();
+
+private:
+  typedef struct Entry {
+    Glyph glyph;
+    uint32_t lastUsed;
+    // GLYPH_SIZE_CLASSES if the glyph has no mask
+    uint8_t sizeClass;
+    bool used;
+  } Entry;
+
+  Entry _entries[GLYPH_CACHE_MAX_ENTRIES] = {};
+  uint8_t *_arena = nullptr;
+  uint16_t _slabCount;
+  // size class per slab, GLYPH_SIZE_CLASSES for free slabs
+  uint8_t _slabClass[GLYPH_MAX_SLABS];
+  // occupied objects per slab, at most GLYPH_SLAB_BYTES / GLYPH_MIN_CLASS_BYTES = 64
+  uint64_t _slabUsed[GLYPH_MAX_SLABS] = {};
+  uint32_t _clock = 0;
+  GlyphCacheStats _stats = {};
+  uint8_t *allocate(uint8_t sizeClass);
+  void release(uint8_t *mask, uint8_t sizeClass);
+  void evict(Entry *entry);
+  Entry *leastRecentlyUsed();
+  static size_t classBytes(uint8_t sizeClass) { return GLYPH_MIN_CLASS_BYTES << sizeClass; }
+};
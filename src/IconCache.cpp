@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "IconCache.h"
+
+IconCache::IconCache(size_t budget) {
+  _budget = budget;
+  _stats.bytesBudget = budget;
+}
+
+const uint16_t *IconCache::get(uint32_t id, uint16_t *w, uint16_t *h) {
+  for (Entry &entry : _entries) {
+    if (entry.pixels && entry.id == id) {
+      entry.lastUsed = ++_clock;
+      *w = entry.width;
+      *h = entry.height;
+      _stats.hits++;
+      return entry.pixels;
+    }
+  }
+  _stats.misses++;
+  return nullptr;
+}
+
+uint16_t *IconCache::put(uint32_t id, uint16_t w, uint16_t h) {
+  size_t bytes = w * h * sizeof(uint16_t);
+  if (bytes > _budget)
+    return nullptr;
+
+  remove(id);
+  Entry *slot = nullptr;
+  // make room: a free slot and enough bytes left in the budget
+  while (true) {
+    if (!slot) {
+      for (Entry &entry : _entries) {
+        if (!entry.pixels) {
+          slot = &entry;
+          break;
+        }
+      }
+    }
+    if (slot && _stats.bytesUsed + bytes <= _budget)
+      break;
+    Entry *victim = leastRecentlyUsed();
+    if (!victim)
+      return nullptr;
+    evict(victim);
+    _stats.evictions++;
+  }
+
+#ifdef BOARD_HAS_PSRAM
+  uint16_t *pixels = (uint16_t *)ps_malloc(bytes);
+#else
+  uint16_t *pixels = (uint16_t *)malloc(bytes);
+#endif
+  if (!pixels) {
+    log_w("Failed to allocate %zu bytes for icon cache entry.", bytes);
+    return nullptr;
+  }
+
+  *slot = {id, w, h, ++_clock, pixels};
+  _stats.bytesUsed += bytes;
+  return pixels;
+}
+
+void IconCache::remove(uint32_t id) {
+  for (Entry &entry : _entries) {
+    if (entry.pixels && entry.id == id) {
+      evict(&entry);
+    }
+  }
+}
+
+void IconCache::clear() {
+  for (Entry &entry : _entries) {
+    if (entry.pixels) {
+      evict(&entry);
+    }
+  }
+}
+
+IconCacheStats IconCache::getStats() {
+  return _stats;
+}
+
+void IconCache::evict(Entry *entry) {
+  _stats.bytesUsed -= entry->width * entry->height * sizeof(uint16_t);
+  free(entry->pixels);
+  *entry = {};
+}
+
+IconCache::Entry *IconCache::leastRecentlyUsed() {
+  Entry *result = nullptr;
+  for (Entry &entry : _entries) {
+    if (entry.pixels && (!result || entry.lastUsed < result->lastUsed)) {
+      result = &entry;
+    }
+  }
+  return result;
+}
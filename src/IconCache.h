@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+
+// Byte budget for decoded icon pixels, override with -D ICON_CACHE_BYTES=... in platformio.ini.
+// A full repaint draws about 45 KB worth of icons.
+#ifndef ICON_CACHE_BYTES
+  #ifdef BOARD_HAS_PSRAM
+    #define ICON_CACHE_BYTES (256 * 1024)
+  #else
+    #define ICON_CACHE_BYTES (48 * 1024)
+  #endif
+#endif
+
+#ifndef ICON_CACHE_MAX_ENTRIES
+  #define ICON_CACHE_MAX_ENTRIES 24
+#endif
+
+typedef struct IconCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  size_t bytesUsed;
+  size_t bytesBudget;
+} IconCacheStats;
+
+/**
+ * Keeps the RGB565 pixels of recently drawn icons in RAM (PSRAM if the board has it), keyed by
+ * icon ID. The least recently used icons are evicted once the byte budget would be exceeded.
+ */
+class IconCache {
+public:
+  IconCache(size_t budget);
+  // Returns the cached pixels and their dimensions or nullptr on a miss (which is counted as such).
+  const uint16_t *get(uint32_t id, uint16_t *w, uint16_t *h);
+  // Returns a buffer for w x h pixels the caller has to fill, nullptr if it doesn't fit the budget.
+  uint16_t *put(uint32_t id, uint16_t w, uint16_t h);
+  // Drops an entry again, e.g. because filling the buffer returned by put() failed.
+  void remove(uint32_t id);
+  void clear();
+  IconCacheStats getStats();
+
+private:
+  typedef struct Entry {
+    uint32_t id;
+    uint16_t width;
+    uint16_t height;
+    uint32_t lastUsed;
+    uint16_t *pixels;
+  } Entry;
+
+  Entry _entries[ICON_CACHE_MAX_ENTRIES] = {};
+  size_t _budget;
+  uint32_t _clock = 0;
+  IconCacheStats _stats = {};
+  void evict(Entry *entry);
+  Entry *leastRecentlyUsed();
+};
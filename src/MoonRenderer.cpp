@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "MoonRenderer.h"
+
+// All coordinates are Q8 fixed-point relative to the center of the disc.
+MoonRenderer::MoonRenderer(uint16_t diameter, double illumination, bool waxing, bool mirrored,
+                           bool antiAliased) {
+  _diameter = diameter;
+  if (illumination < 0)
+    illumination = 0;
+  if (illumination > 1)
+    illumination = 1;
+  _terminator = (int32_t)(256 - 512 * illumination);
+  _litFromRight = waxing != mirrored;
+  _antiAliased = antiAliased;
+}
+
+void MoonRenderer::renderRows(uint16_t *buf, uint16_t firstRow, uint16_t rows) {
+  int32_t radius = _diameter * 128;
+  uint8_t subsamples = _antiAliased ? MOON_SUBSAMPLES : 1;
+  // disc and lit spans [x0, x1) per sub-sample
+  int32_t discSpan[MOON_SUBSAMPLES][2];
+  int32_t litSpan[MOON_SUBSAMPLES][2];
+
+  for (uint16_t row = firstRow; row < firstRow + rows; row++) {
+    for (uint8_t s = 0; s < subsamples; s++) {
+      // y at the center of the sub-sample
+      int32_t y = (int32_t)(((row * subsamples + s) * 2 + 1) * 128 / subsamples) - radius;
+      int32_t squared = radius * radius - y * y;
+      int32_t halfWidth = squared > 0 ? isqrt(squared) : 0;
+      int32_t edge = halfWidth * _terminator / 256;
+      discSpan[s][0] = -halfWidth;
+      discSpan[s][1] = halfWidth;
+      litSpan[s][0] = _litFromRight ? edge : -halfWidth;
+      litSpan[s][1] = _litFromRight ? halfWidth : -edge;
+    }
+
+    uint16_t *out = buf + (row - firstRow) * _diameter;
+    for (uint16_t col = 0; col < _diameter; col++) {
+      int32_t x0 = col * 256 - radius;
+      uint32_t disc = 0, lit = 0;
+      for (uint8_t s = 0; s < subsamples; s++) {
+        disc += overlap(discSpan[s][0], discSpan[s][1], x0, x0 + 256);
+        lit += overlap(litSpan[s][0], litSpan[s][1], x0, x0 + 256);
+      }
+      disc /= subsamples;
+      lit /= subsamples;
+      if (!_antiAliased) {
+        disc = disc >= 128 ? 256 : 0;
+        lit = lit >= 128 && disc ? 256 : 0;
+      }
+      *out++ = blend(lit, disc - lit);
+    }
+  }
+}
+
+uint32_t MoonRenderer::isqrt(uint32_t value) {
+  uint32_t result = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
+
+int32_t MoonRenderer::overlap(int32_t a0, int32_t a1, int32_t b0, int32_t b1) {
+  int32_t lo = a0 > b0 ? a0 : b0;
+  int32_t hi = a1 < b1 ? a1 : b1;
+  return hi > lo ? hi - lo : 0;
+}
+
+// Coverages are 0..256, the background is black
+uint16_t MoonRenderer::blend(uint32_t lit, uint32_t dark) {
+  uint32_t r = (((MOON_LIT_COLOR >> 16) & 0xFF) * lit + ((MOON_DARK_COLOR >> 16) & 0xFF) * dark) >> 8;
+  uint32_t g = (((MOON_LIT_COLOR >> 8) & 0xFF) * lit + ((MOON_DARK_COLOR >> 8) & 0xFF) * dark) >> 8;
+  uint32_t b = ((MOON_LIT_COLOR & 0xFF) * lit + (MOON_DARK_COLOR & 0xFF) * dark) >> 8;
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
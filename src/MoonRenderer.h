@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stdint.h>
+
+// Colors of the lit and the dark (earthshine) part of the disc, RGB888
+#define MOON_LIT_COLOR 0xE6E4D2
+#define MOON_DARK_COLOR 0x282830
+// Vertical sub-samples per pixel row for anti-aliased edges, horizontally coverage is exact
+#define MOON_SUBSAMPLES 4
+
+/**
+ * Rasterizes the moon disc for a given illumination with fixed-point maths, replacing the 32
+ * pre-rendered moon phase images. The terminator is the projection of the shadow boundary,
+ * an ellipse whose half-width is cos(phase angle) = 1 - 2 * illumination times that of the disc.
+ */
+class MoonRenderer {
+public:
+  // illumination: lit fraction 0..1, waxing: lit from the right (northern hemisphere view),
+  // mirrored: southern hemisphere view, i.e. left and right are swapped
+  MoonRenderer(uint16_t diameter, double illumination, bool waxing, bool mirrored,
+               bool antiAliased);
+  // Renders rows [firstRow, firstRow + rows) into buf (diameter pixels per row, RGB565) on black.
+  void renderRows(uint16_t *buf, uint16_t firstRow, uint16_t rows);
+  uint16_t diameter() { return _diameter; }
+
+private:
+  uint16_t _diameter;
+  // cos(phase angle) in Q8
+  int32_t _terminator;
+  bool _litFromRight;
+  bool _antiAliased;
+  static uint32_t isqrt(uint32_t value);
+  static int32_t overlap(int32_t a0, int32_t a1, int32_t b0, int32_t b1);
+  static uint16_t blend(uint32_t litCoverage, uint32_t darkCoverage);
+};
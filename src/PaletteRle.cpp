@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "PaletteRle.h"
+
+PaletteRleDecoder::PaletteRleDecoder(PrleReadFn read, void *context) {
+  _read = read;
+  _context = context;
+}
+
+bool PaletteRleDecoder::begin() {
+  uint8_t header[PRLE_HEADER_SIZE];
+  if (!readBytes(header, sizeof(header)))
+    return false;
+  _width = header[0] | (header[1] << 8);
+  _height = header[2] | (header[3] << 8);
+  _paletteSize = header[4] | (header[5] << 8);
+  _bitsPerIndex = header[6];
+  if (_paletteSize == 0 || _paletteSize > PRLE_MAX_PALETTE_SIZE ||
+      (_bitsPerIndex != 4 && _bitsPerIndex != 8) ||
+      (_bitsPerIndex == 4 && _paletteSize > 16))
+    return false;
+  // palette entries are kept in wire order, the bytes are copied as-is
+  return readBytes((uint8_t *)_palette, _paletteSize * sizeof(uint16_t));
+}
+
+bool PaletteRleDecoder::readRow(uint16_t *row) {
+  uint16_t col = 0;
+  while (col < _width) {
+    if (_runLeft) {
+      uint16_t n = _width - col < _runLeft ? _width - col : _runLeft;
+      _runLeft -= n;
+      while (n--) {
+        row[col++] = _runColor;
+      }
+    } else if (_literalLeft) {
+      uint16_t n = _width - col;
+      if (n > _literalLeft)
+        n = _literalLeft;
+      if (n > _inputLen - _inputPos)
+        n = _inputLen - _inputPos;
+      if (_bitsPerIndex == 8 && n > 0) {
+        // fast path, straight from the input buffer; _palette has PRLE_MAX_PALETTE_SIZE entries
+        // hence corrupt indices can't read out of bounds
+        _literalLeft -= n;
+        while (n--) {
+          row[col++] = _palette[_input[_inputPos++]];
+        }
+      } else if (!nextLiteral(&row[col++])) {
+        return false;
+      }
+    } else {
+      uint8_t control;
+      if (!nextByte(&control))
+        return false;
+      if (control & 0x80) {
+        uint8_t index;
+        if (!nextByte(&index) || (_bitsPerIndex == 8 ? index : index & 0x0F) >= _paletteSize)
+          return false;
+        _runColor = _palette[_bitsPerIndex == 8 ? index : index & 0x0F];
+        _runLeft = (control & 0x7F) + 1;
+      } else {
+        _literalLeft = control + 1;
+        // literals always start on a byte boundary
+        _lowNibblePending = false;
+      }
+    }
+  }
+  return true;
+}
+
+bool PaletteRleDecoder::nextLiteral(uint16_t *color) {
+  uint8_t index;
+  if (_bitsPerIndex == 8) {
+    if (!nextByte(&index))
+      return false;
+  } else if (_lowNibblePending) {
+    index = _nibbles & 0x0F;
+    _lowNibblePending = false;
+  } else {
+    if (!nextByte(&_nibbles))
+      return false;
+    index = _nibbles >> 4;
+    _lowNibblePending = true;
+  }
+  if (index >= _paletteSize)
+    return false;
+  *color = _palette[index];
+  _literalLeft--;
+  return true;
+}
+
+bool PaletteRleDecoder::nextByte(uint8_t *b) {
+  if (_inputPos == _inputLen) {
+    _inputLen = _read(_context, _input, sizeof(_input));
+    _inputPos = 0;
+    _bytesRead += _inputLen;
+    if (_inputLen == 0)
+      return false;
+  }
+  *b = _input[_inputPos++];
+  return true;
+}
+
+bool PaletteRleDecoder::readBytes(uint8_t *buf, size_t len) {
+  while (len--) {
+    if (!nextByte(buf++))
+      return false;
+  }
+  return true;
+}
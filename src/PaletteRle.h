@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Palette-indexed, run-length encoded icons as generated by tools/icons.py. The stream starts with
+//   uint16 width, uint16 height, uint16 palette size, uint8 bits per index (4 or 8), uint8 reserved
+// (little-endian) followed by the palette (big-endian RGB565, i.e. as it goes over the wire) and
+// the RLE data for all rows, top-down. Each RLE packet starts with a control byte c:
+//   c & 0x80 -> run: the next index is repeated (c & 0x7F) + 1 times
+//   else     -> literal: c + 1 indices follow, two per byte (high nibble first) for 4 bit indices
+// Runs and literals may cross row boundaries. Stand-alone .prl files prepend the magic "PRLE".
+#define PRLE_MAGIC "PRLE"
+#define PRLE_EXTENSION ".prl"
+#define PRLE_HEADER_SIZE 8
+#define PRLE_MAX_PALETTE_SIZE 256
+// The decoder reads its input in chunks of this size
+#define PRLE_INPUT_BUFFER 64
+
+// Reads up to len bytes into buf, returns the number of bytes read (0 at the end of the data).
+typedef size_t (*PrleReadFn)(void *context, uint8_t *buf, size_t len);
+
+/**
+ * Streaming decoder, decodes one row at a time and never holds more than PRLE_INPUT_BUFFER bytes of
+ * the compressed data in memory.
+ */
+class PaletteRleDecoder {
+public:
+  PaletteRleDecoder(PrleReadFn read, void *context);
+  // Reads header and palette, returns false if the data isn't a valid PRLE stream.
+  bool begin();
+  // Decodes the next row into row (width() pixels), returns false on truncated or corrupt data.
+  bool readRow(uint16_t *row);
+  uint16_t width() { return _width; }
+  uint16_t height() { return _height; }
+  // Number of compressed bytes pulled from the reader so far
+  uint32_t bytesRead() { return _bytesRead; }
+
+private:
+  PrleReadFn _read;
+  void *_context;
+  uint16_t _width = 0;
+  uint16_t _height = 0;
+  uint16_t _paletteSize = 0;
+  uint8_t _bitsPerIndex = 0;
+  uint16_t _palette[PRLE_MAX_PALETTE_SIZE] = {};
+  uint8_t _input[PRLE_INPUT_BUFFER];
+  uint8_t _inputPos = 0;
+  uint8_t _inputLen = 0;
+  uint32_t _bytesRead = 0;
+  // state of the current packet
+  uint8_t _runLeft = 0;
+  uint16_t _runColor = 0;
+  uint8_t _literalLeft = 0;
+  bool _lowNibblePending = false;
+  uint8_t _nibbles = 0;
+  bool nextByte(uint8_t *b);
+  bool readBytes(uint8_t *buf, size_t len);
+  bool nextLiteral(uint16_t *color);
+};
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "RenderQueue.h"
+
+bool RenderQueue::begin() {
+  _queue = xQueueCreate(RENDER_QUEUE_LENGTH, sizeof(RenderCommand));
+  if (!_queue) {
+    log_e("Not enough memory for the render queue.");
+    return false;
+  }
+  return true;
+}
+
+bool RenderQueue::post(const RenderCommand &command, TickType_t wait) {
+  if (xQueueSend(_queue, &command, wait) != pdTRUE) {
+    _stats.dropped++;
+    return false;
+  }
+  _stats.posted++;
+  if (_listener)
+    _listener(_listenerContext);
+  return true;
+}
+
+bool RenderQueue::postClockTick() {
+  RenderCommand command = {RENDER_CLOCK_TICK};
+  return post(command, 0);
+}
+
+bool RenderQueue::postLightReading(float lux, uint32_t brightness) {
+  RenderCommand command = {RENDER_LIGHT_READING};
+  command.light.lux = lux;
+  command.light.brightness = brightness;
+  return post(command, 0);
+}
+
+bool RenderQueue::postWeather() {
+  RenderCommand command = {RENDER_WEATHER};
+  return post(command, portMAX_DELAY);
+}
+
+bool RenderQueue::postProgress(const char *text, int8_t percentage) {
+  RenderCommand command = {RENDER_PROGRESS};
+  command.progress.text = text;
+  command.progress.percentage = percentage;
+  return post(command, portMAX_DELAY);
+}
+
+bool RenderQueue::receive(RenderBatch *batch, TickType_t wait) {
+  *batch = {};
+  RenderCommand command;
+  if (xQueueReceive(_queue, &command, wait) != pdTRUE)
+    return false;
+  merge(batch, command);
+  while (xQueueReceive(_queue, &command, 0) == pdTRUE) {
+    merge(batch, command);
+  }
+  _stats.batches++;
+  _stats.coalesced += batch->commands - 1;
+  return true;
+}
+
+void RenderQueue::merge(RenderBatch *batch, const RenderCommand &command) {
+  batch->commands++;
+  switch (command.type) {
+  case RENDER_CLOCK_TICK:
+    batch->clockTick = true;
+    break;
+  case RENDER_LIGHT_READING:
+    batch->light = true;
+    batch->lux = command.light.lux;
+    batch->brightness = command.light.brightness;
+    break;
+  case RENDER_WEATHER:
+    batch->weather = true;
+    break;
+  case RENDER_PROGRESS:
+    // only the latest step is still worth showing
+    batch->progress = true;
+    batch->progressText = command.progress.text;
+    batch->progressPercentage = command.progress.percentage;
+    break;
+  }
+}
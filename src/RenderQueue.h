@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// Commands that can be waiting at once, posting a tick or a light reading to a full queue drops it
+#ifndef RENDER_QUEUE_LENGTH
+  #define RENDER_QUEUE_LENGTH 8
+#endif
+
+typedef enum RenderCommandType {
+  // the clock's second or minute changed
+  RENDER_CLOCK_TICK,
+  RENDER_LIGHT_READING,
+  // new weather data is in, everything derived from it is refreshed
+  RENDER_WEATHER,
+  // a step of the progress screen shown until the first weather data is in
+  RENDER_PROGRESS
+} RenderCommandType;
+
+typedef struct RenderCommand {
+  RenderCommandType type;
+  union {
+    struct {
+      float lux;
+      uint32_t brightness;
+    } light;
+    struct {
+      // must outlive the command, e.g. a string literal
+      const char *text;
+      int8_t percentage;
+    } progress;
+  };
+} RenderCommand;
+
+// Everything waiting in the queue merged: flags for what to refresh, the latest values otherwise.
+typedef struct RenderBatch {
+  bool clockTick;
+  bool light;
+  float lux;
+  uint32_t brightness;
+  bool weather;
+  bool progress;
+  const char *progressText;
+  int8_t progressPercentage;
+  // commands merged into this batch
+  uint8_t commands;
+} RenderBatch;
+
+// Called after every command posted, e.g. to wake a render job that doesn't block on the queue
+typedef void (*RenderQueueListener)(void *context);
+
+typedef struct RenderQueueStats {
+  uint32_t posted;
+  // posts to a full queue which weren't waited for
+  uint32_t dropped;
+  uint32_t batches;
+  // commands merged into a batch with others, i.e. draws saved
+  uint32_t coalesced;
+} RenderQueueStats;
+
+/**
+ * Hands draw requests from the tasks producing data to the one task that owns the display and the
+ * font renderer. The render task takes everything waiting at once and draws it as one frame, a
+ * light reading replaces an older one and a tick or a weather update pending twice is done once.
+ */
+class RenderQueue {
+public:
+  // Creates the queue, returns false if out of memory.
+  bool begin();
+  // Returns false if the queue stayed full for wait ticks (0: don't wait).
+  bool post(const RenderCommand &command, TickType_t wait);
+  bool postClockTick();
+  bool postLightReading(float lux, uint32_t brightness);
+  // Waits for room, weather updates and progress steps must not get lost.
+  bool postWeather();
+  bool postProgress(const char *text, int8_t percentage);
+  // Waits up to wait ticks for at least one command, then merges all waiting ones into batch.
+  // Returns false if there was none.
+  bool receive(RenderBatch *batch, TickType_t wait = portMAX_DELAY);
+  void setListener(RenderQueueListener listener, void *context) {
+    _listener = listener;
+    _listenerContext = context;
+  }
+  RenderQueueStats getStats() { return _stats; }
+
+private:
+  QueueHandle_t _queue = nullptr;
+  RenderQueueStats _stats = {};
+  RenderQueueListener _listener = nullptr;
+  void *_listenerContext = nullptr;
+  static void merge(RenderBatch *batch, const RenderCommand &command);
+};
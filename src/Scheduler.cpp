@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "Scheduler.h"
+
+#include <sys/time.h>
+
+bool Scheduler::every(const char *name, uint32_t periodMs, ScheduledFn fn, void *context) {
+  ScheduledJob *job = add(name, pdMS_TO_TICKS(periodMs), true, fn, context);
+  return job && xTimerStart(job->timer, 0) == pdPASS;
+}
+
+bool Scheduler::aligned(const char *name, uint32_t alignMs, ScheduledFn fn, void *context) {
+  ScheduledJob *job = add(name, untilBoundary(alignMs), false, fn, context);
+  if (!job)
+    return false;
+  job->alignMs = alignMs;
+  return xTimerStart(job->timer, 0) == pdPASS;
+}
+
+SchedulerStats Scheduler::getStats() {
+  SchedulerStats stats = {_count, 0};
+  for (uint8_t i = 0; i < _count; i++) {
+    stats.fires += _jobs[i].fires;
+  }
+  return stats;
+}
+
+ScheduledJob *Scheduler::add(const char *name, uint32_t periodTicks, bool reload, ScheduledFn fn,
+                             void *context) {
+  if (_count == SCHEDULER_JOBS) {
+    log_e("No room for job %s, raise SCHEDULER_JOBS.", name);
+    return nullptr;
+  }
+  ScheduledJob *job = &_jobs[_count];
+  job->fn = fn;
+  job->context = context;
+  job->timer = xTimerCreate(name, periodTicks > 0 ? periodTicks : 1, reload ? pdTRUE : pdFALSE,
+                            job, onTimer);
+  if (!job->timer) {
+    log_e("Not enough memory for the timer of job %s.", name);
+    return nullptr;
+  }
+  _count++;
+  return job;
+}
+
+void Scheduler::onTimer(TimerHandle_t timer) {
+  ScheduledJob *job = (ScheduledJob *)pvTimerGetTimerID(timer);
+  job->fires++;
+  job->fn(job->context);
+  if (job->alignMs) {
+    // one-shot, changing the period of a dormant timer also starts it
+    xTimerChangePeriod(timer, untilBoundary(job->alignMs), 0);
+  }
+}
+
+TickType_t Scheduler::untilBoundary(uint32_t alignMs) {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  uint32_t periodSeconds = alignMs < 1000 ? 1 : alignMs / 1000;
+  uint32_t intoPeriod = ((now.tv_sec % periodSeconds) * 1000 + now.tv_usec / 1000) % alignMs;
+  TickType_t ticks = pdMS_TO_TICKS(alignMs - intoPeriod + SCHEDULER_ALIGN_SLACK_MS);
+  return ticks > 0 ? ticks : 1;
+}
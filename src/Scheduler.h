@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+// Jobs that can be scheduled at once, each is a FreeRTOS software timer
+#ifndef SCHEDULER_JOBS
+  #define SCHEDULER_JOBS 4
+#endif
+// An aligned job fires this late past the boundary so the wall clock reads the new second or minute
+// even with the tick rounding down
+#ifndef SCHEDULER_ALIGN_SLACK_MS
+  #define SCHEDULER_ALIGN_SLACK_MS 20
+#endif
+
+// Runs in the timer service task: must not block, hand longer work to a task, see notifyTask()
+typedef void (*ScheduledFn)(void *context);
+
+typedef struct ScheduledJob {
+  TimerHandle_t timer;
+  ScheduledFn fn;
+  void *context;
+  // wall clock period the job is aligned to, 0 for a fixed rate
+  uint32_t alignMs;
+  uint32_t fires;
+} ScheduledJob;
+
+typedef struct SchedulerStats {
+  uint8_t jobs;
+  // all jobs together, i.e. the wakeups the scheduler caused
+  uint32_t fires;
+} SchedulerStats;
+
+/**
+ * Wakes the tasks on deadlines instead of having each poll in a vTaskDelay() loop. Fixed rate jobs
+ * are auto-reload timers, the next deadline is counted from the previous one so the period doesn't
+ * drift by however long the job's work took. Aligned jobs fire on wall clock boundaries, e.g. right
+ * after each full minute, and re-arm from the clock every time, which also follows a time sync.
+ */
+class Scheduler {
+public:
+  // Calls fn every periodMs starting periodMs from now, false if out of memory or jobs.
+  bool every(const char *name, uint32_t periodMs, ScheduledFn fn, void *context);
+  // Calls fn just after every multiple of alignMs on the wall clock (UTC, so whole minutes and
+  // seconds are local ones too), false if out of memory or jobs.
+  bool aligned(const char *name, uint32_t alignMs, ScheduledFn fn, void *context);
+  SchedulerStats getStats();
+  // A ScheduledFn waking the task passed as context from ulTaskNotifyTake().
+  static void notifyTask(void *task) { xTaskNotifyGive((TaskHandle_t)task); }
+
+private:
+  ScheduledJob _jobs[SCHEDULER_JOBS] = {};
+  uint8_t _count = 0;
+  ScheduledJob *add(const char *name, uint32_t periodTicks, bool reload, ScheduledFn fn,
+                    void *context);
+  static void onTimer(TimerHandle_t timer);
+  static TickType_t untilBoundary(uint32_t alignMs);
+};
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Hands complete copies of T from one writer task to one reader task without locks. The writer
+ * fills a slot only it can see and publishes it with a single atomic exchange, the reader swaps
+ * the latest published slot for the one it is done with. Neither ever waits for the other and a
+ * slot is only written again once the reader has let go of it, hence the third slot: one is read,
+ * one is published, one is being written.
+ */
+template <typename T> class SnapshotBuffer {
+public:
+  // The writer's private slot, whatever was in it before is stale. A slot that isn't published is
+  // abandoned, the next call returns it again.
+  T *beginWrite() { return &_slots[_back]; }
+  // Makes the slot from beginWrite() the latest snapshot, an older one the reader hasn't picked up
+  // yet becomes the next slot to write.
+  void publish() {
+    _back = _shared.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    _published.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Picks up the latest snapshot if one was published since the last call, true if so. The one
+  // read before is handed back to the writer, pointers into it must not be used anymore.
+  bool acquire() {
+    if (!(_shared.load(std::memory_order_relaxed) & FRESH))
+      return false;
+    _front = _shared.exchange(_front, std::memory_order_acq_rel) & INDEX;
+    _current = &_slots[_front];
+    return true;
+  }
+  // The snapshot picked up by the last acquire(), nullptr before the first one.
+  const T *current() const { return _current; }
+  // Snapshots published so far, also those replaced before the reader got to them.
+  uint32_t getPublished() const { return _published.load(std::memory_order_relaxed); }
+
+private:
+  static const uint8_t INDEX = 0x03;
+  static const uint8_t FRESH = 0x04;
+  T _slots[3];
+  // only touched by the reader
+  uint8_t _front = 0;
+  const T *_current = nullptr;
+  // only touched by the writer
+  uint8_t _back = 2;
+  // index of the published slot, FRESH until the reader takes it
+  std::atomic<uint8_t> _shared{1};
+  std::atomic<uint32_t> _published{0};
+};
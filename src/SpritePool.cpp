@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "SpritePool.h"
+
+SpritePool::SpritePool(TFT_eSPI *tft, size_t budget) {
+  _tft = tft;
+  _stats.bytesBudget = budget;
+}
+
+TFT_eSprite *SpritePool::checkout(int16_t w, int16_t h, uint8_t depth, const uint16_t *palette) {
+  _stats.checkouts++;
+  size_t size = bytes(w, h, depth);
+  for (Slot &slot : _slots) {
+    if (slot.sprite && slot.sprite->created() && !slot.inUse && slot.width == w &&
+        slot.height == h && slot.depth == depth) {
+      slot.inUse = true;
+      slot.lastUsed = ++_clock;
+      _stats.reuses++;
+      lend(size);
+      setPalette(slot.sprite, depth, palette);
+      return slot.sprite;
+    }
+  }
+
+  if (w <= 0 || h <= 0 || size > _stats.bytesBudget - _stats.bytesInUse) {
+    _stats.exhausted++;
+    return nullptr;
+  }
+  // idle sprites make room first, the check above guarantees that's enough
+  while (_stats.bytesAllocated + size > _stats.bytesBudget && release()) {
+  }
+  Slot *empty = nullptr;
+  for (Slot &slot : _slots) {
+    if (!slot.sprite || !slot.sprite->created()) {
+      empty = &slot;
+      break;
+    }
+  }
+  if (!empty && release()) {
+    for (Slot &slot : _slots) {
+      if (!slot.sprite->created()) {
+        empty = &slot;
+        break;
+      }
+    }
+  }
+  if (!empty) {
+    _stats.exhausted++;
+    return nullptr;
+  }
+
+  if (!empty->sprite)
+    empty->sprite = new TFT_eSprite(_tft);
+  empty->sprite->setColorDepth(depth);
+  if (!empty->sprite->createSprite(w, h)) {
+    log_w("Not enough memory for a %dx%d sprite, %zu bytes pooled.", w, h, _stats.bytesAllocated);
+    _stats.exhausted++;
+    return nullptr;
+  }
+  empty->width = w;
+  empty->height = h;
+  empty->depth = depth;
+  empty->inUse = true;
+  empty->lastUsed = ++_clock;
+  _stats.bytesAllocated += size;
+  if (_stats.bytesAllocated > _stats.peakBytesAllocated)
+    _stats.peakBytesAllocated = _stats.bytesAllocated;
+  lend(size);
+  setPalette(empty->sprite, depth, palette);
+  return empty->sprite;
+}
+
+void SpritePool::checkin(TFT_eSprite *sprite) {
+  for (Slot &slot : _slots) {
+    if (slot.sprite == sprite && slot.inUse) {
+      slot.inUse = false;
+      _stats.bytesInUse -= bytes(slot.width, slot.height, slot.depth);
+      return;
+    }
+  }
+}
+
+bool SpritePool::render(const ScreenRect &rect, BandDrawFn draw, void *context,
+                        uint16_t background, uint8_t depth, const uint16_t *palette) {
+  int16_t x0 = rect.x < 0 ? 0 : rect.x;
+  int16_t y0 = rect.y < 0 ? 0 : rect.y;
+  int16_t x1 = rect.x + rect.w > _tft->width() ? _tft->width() : rect.x + rect.w;
+  int16_t y1 = rect.y + rect.h > _tft->height() ? _tft->height() : rect.y + rect.h;
+  if (x1 <= x0 || y1 <= y0)
+    return true;
+
+  int16_t rows = y1 - y0;
+  TFT_eSprite *sprite = checkout(x1 - x0, rows, depth, palette);
+  while (!sprite && rows > SPRITE_POOL_MIN_BAND) {
+    rows = rows > BAND_HEIGHT ? BAND_HEIGHT : rows / 2;
+    if (rows < SPRITE_POOL_MIN_BAND)
+      rows = SPRITE_POOL_MIN_BAND;
+    sprite = checkout(x1 - x0, rows, depth, palette);
+  }
+  if (!sprite) {
+    _stats.failed++;
+    return false;
+  }
+  if (rows < y1 - y0)
+    _stats.banded++;
+
+  for (int16_t y = y0; y < y1; y += rows) {
+    ScreenRect band = {x0, y, (int16_t)(x1 - x0), (int16_t)(y1 - y < rows ? y1 - y : rows)};
+    sprite->fillSprite(background);
+    // shifted such that the same display coordinates can be used, see BandRenderer::drawBand()
+    sprite->setViewport(-band.x, -band.y, band.x + band.w, band.y + band.h, true);
+    draw(context, sprite, band);
+    sprite->resetViewport();
+    sprite->pushSprite(band.x, band.y, 0, 0, band.w, band.h);
+  }
+  checkin(sprite);
+  return true;
+}
+
+void SpritePool::ramp(uint16_t *palette, uint8_t depth, uint16_t color, uint16_t background) {
+  uint8_t last = (1 << depth) - 1;
+  for (uint8_t i = 0; i < last; i++) {
+    palette[i] = _tft->alphaBlend(i * 255 / last, color, background);
+  }
+  palette[last] = color;
+}
+
+void SpritePool::setPalette(TFT_eSprite *sprite, uint8_t depth, const uint16_t *palette) {
+  if (!palette)
+    return;
+  if (depth == 4)
+    sprite->createPalette(palette, 16);
+  else if (depth == 1)
+    sprite->setBitmapColor(palette[1], palette[0]);
+}
+
+void SpritePool::lend(size_t size) {
+  _stats.bytesInUse += size;
+  if (_stats.bytesInUse > _stats.peakBytesInUse)
+    _stats.peakBytesInUse = _stats.bytesInUse;
+}
+
+bool SpritePool::release() {
+  Slot *oldest = nullptr;
+  for (Slot &slot : _slots) {
+    if (slot.sprite && slot.sprite->created() && !slot.inUse &&
+        (!oldest || slot.lastUsed < oldest->lastUsed))
+      oldest = &slot;
+  }
+  if (!oldest)
+    return false;
+  oldest->sprite->deleteSprite();
+  _stats.bytesAllocated -= bytes(oldest->width, oldest->height, oldest->depth);
+  return true;
+}
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#include "BandRenderer.h"
+
+// Pixel bytes the pooled sprites may hold at once, checked out or kept for reuse. Override with
+// -D SPRITE_POOL_BYTES=... in platformio.ini. Widgets only draw through the pool if there's no
+// memory for the band sprite (see BandRenderer), hence the default stays below that: it holds the
+// clock and the light readout as 4 bit sprites (10.5 + 0.7 KB), at 16 bit the clock in 16 row
+// bands (7.5 + 3 KB). With PSRAM both fit whole at 16 bit (41 + 3 KB).
+#ifndef SPRITE_POOL_BYTES
+  #ifdef BOARD_HAS_PSRAM
+    #define SPRITE_POOL_BYTES (48 * 1024)
+  #else
+    #define SPRITE_POOL_BYTES (12 * 1024)
+  #endif
+#endif
+
+#define SPRITE_POOL_SLOTS 4
+// render() halves its bands down to this height before it gives up
+#define SPRITE_POOL_MIN_BAND 8
+// Color depth of the sprites for widgets showing only anti-aliased text of one color: 4 (16 shades,
+// a quarter of the RAM of RGB565) or 1 (no anti-aliasing, a sixteenth), 16 for RGB565. Only the
+// pooled sprites have it, the band sprite the widgets draw into by default stays RGB565.
+#ifndef TEXT_SPRITE_DEPTH
+  #define TEXT_SPRITE_DEPTH 4
+#endif
+
+typedef struct SpritePoolStats {
+  uint32_t checkouts;
+  // checkouts served by a sprite kept from an earlier one
+  uint32_t reuses;
+  // checkouts neither the budget nor the heap had room for
+  uint32_t exhausted;
+  // render() calls which drew in bands, or not at all
+  uint32_t banded;
+  uint32_t failed;
+  size_t bytesInUse;
+  size_t peakBytesInUse;
+  // checked out plus kept for reuse
+  size_t bytesAllocated;
+  size_t peakBytesAllocated;
+  size_t bytesBudget;
+} SpritePoolStats;
+
+/**
+ * Lends out sprites of exactly the requested size and color depth within a byte budget. 1 and 4 bit
+ * sprites are palettized, their pixels are expanded to RGB565 only when pushed. Returned sprites
+ * are kept and handed out again for the same size, which widgets with fixed bounds ask for every
+ * frame, so the heap sees one allocation per size rather than one per frame. Kept sprites are
+ * deleted, least recently used first, when a new size needs their room.
+ */
+class SpritePool {
+public:
+  SpritePool(TFT_eSPI *tft, size_t budget);
+  // A sprite of w x h pixels, nullptr if the pool is exhausted. Its content is undefined. depth 16
+  // (RGB565), 4 or 1 with a palette of 1 << depth colors.
+  TFT_eSprite *checkout(int16_t w, int16_t h, uint8_t depth = 16,
+                        const uint16_t *palette = nullptr);
+  void checkin(TFT_eSprite *sprite);
+  // Draws rect (in display coordinates, clipped to the display) off-screen and pushes it in one
+  // piece. Without room for a sprite of that size it's drawn and pushed in bands, false if not even
+  // SPRITE_POOL_MIN_BAND rows fit and the caller has to draw onto the display directly.
+  // The sprite is cleared to background, a palette index for palettized sprites.
+  bool render(const ScreenRect &rect, BandDrawFn draw, void *context, uint16_t background,
+              uint8_t depth = 16, const uint16_t *palette = nullptr);
+  // Fills palette with the 1 << depth colors from background to color for text drawn with
+  // CachedFontRender::setDrawer(canvas, depth).
+  void ramp(uint16_t *palette, uint8_t depth, uint16_t color, uint16_t background);
+  SpritePoolStats getStats() { return _stats; }
+
+private:
+  typedef struct Slot {
+    TFT_eSprite *sprite;
+    uint32_t lastUsed;
+    int16_t width;
+    int16_t height;
+    uint8_t depth;
+    bool inUse;
+  } Slot;
+
+  TFT_eSPI *_tft;
+  Slot _slots[SPRITE_POOL_SLOTS] = {};
+  uint32_t _clock = 0;
+  SpritePoolStats _stats = {};
+  void lend(size_t size);
+  static void setPalette(TFT_eSprite *sprite, uint8_t depth, const uint16_t *palette);
+  // Deletes the least recently used idle sprite, false if there is none.
+  bool release();
+  // rows are padded to full bytes
+  static size_t bytes(int16_t w, int16_t h, uint8_t depth) {
+    return ((size_t)w * depth + 7) / 8 * h;
+  }
+};
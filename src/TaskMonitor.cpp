@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "TaskMonitor.h"
+
+bool TaskMonitor::start(const TaskDef *tasks, uint8_t count) {
+  bool started = true;
+  for (uint8_t i = 0; i < count; i++) {
+    const TaskDef &task = tasks[i];
+    // the depth is counted in StackType_t, which ESP-IDF makes a byte
+    TaskHandle_t handle =
+        xTaskCreateStatic(task.function, task.name, task.stackBytes / sizeof(StackType_t), nullptr,
+                          task.priority, task.stack, task.tcb);
+    if (task.handle)
+      *task.handle = handle;
+    if (!handle) {
+      log_e("Couldn't start task %s.", task.name);
+      started = false;
+      continue;
+    }
+    started = watch(handle, task.stackBytes) && started;
+  }
+  return started;
+}
+
+bool TaskMonitor::watch(TaskHandle_t handle, uint32_t stackBytes) {
+  if (_count == TASK_MONITOR_TASKS) {
+    log_e("Can't watch task %s, raise TASK_MONITOR_TASKS.", pcTaskGetName(handle));
+    return false;
+  }
+  TaskUsage &usage = _tasks[_count];
+  usage.handle = handle;
+  usage.name = pcTaskGetName(handle);
+  usage.stackBytes = stackBytes;
+  usage.minFreeBytes = stackBytes;
+  _count++;
+  return true;
+}
+
+void TaskMonitor::sample() {
+  for (uint8_t i = 0; i < _count; i++) {
+    TaskUsage &usage = _tasks[i];
+    uint32_t freeBytes = uxTaskGetStackHighWaterMark(usage.handle) * sizeof(StackType_t);
+    if (freeBytes < usage.minFreeBytes)
+      usage.minFreeBytes = freeBytes;
+  }
+#if TASK_MONITOR_CPU
+  sampleCpu();
+#endif
+}
+
+#if TASK_MONITOR_CPU
+void TaskMonitor::sampleCpu() {
+  uint32_t totalRunTime;
+  UBaseType_t count = uxTaskGetSystemState(_system, TASK_MONITOR_SYSTEM_TASKS, &totalRunTime);
+  if (count == 0) {
+    log_w("More than %d tasks, raise TASK_MONITOR_SYSTEM_TASKS.", TASK_MONITOR_SYSTEM_TASKS);
+    return;
+  }
+  uint32_t elapsed = totalRunTime - _lastTotalRunTime;
+  _lastTotalRunTime = totalRunTime;
+  for (uint8_t i = 0; i < _count; i++) {
+    TaskUsage &usage = _tasks[i];
+    for (UBaseType_t k = 0; k < count; k++) {
+      if (_system[k].xHandle != usage.handle)
+        continue;
+      uint32_t ran = _system[k].ulRunTimeCounter - usage.lastRunTime;
+      usage.lastRunTime = _system[k].ulRunTimeCounter;
+      usage.cpuPermille = elapsed > 0 ? (uint16_t)((uint64_t)ran * 1000 / elapsed) : 0;
+      if (usage.cpuPermille > usage.peakCpuPermille)
+        usage.peakCpuPermille = usage.cpuPermille;
+      break;
+    }
+  }
+}
+#endif
+
+void TaskMonitor::report() {
+  for (uint8_t i = 0; i < _count; i++) {
+    const TaskUsage &usage = _tasks[i];
+    uint32_t recommended = recommendStack(usage);
+#if TASK_MONITOR_CPU
+    log_i("Task %s: %d/%d bytes of stack used at most, %d would do; CPU %d.%d%%, peak %d.%d%%",
+          usage.name, usage.stackBytes - usage.minFreeBytes, usage.stackBytes, recommended,
+          usage.cpuPermille / 10, usage.cpuPermille % 10, usage.peakCpuPermille / 10,
+          usage.peakCpuPermille % 10);
+#else
+    log_i("Task %s: %d/%d bytes of stack used at most, %d would do", usage.name,
+          usage.stackBytes - usage.minFreeBytes, usage.stackBytes, recommended);
+#endif
+    if (recommended > usage.stackBytes)
+      log_w("Task %s is short of stack headroom, give it %d bytes.", usage.name, recommended);
+  }
+}
+
+uint32_t TaskMonitor::recommendStack(const TaskUsage &usage) {
+  uint32_t used = usage.stackBytes - usage.minFreeBytes;
+  uint32_t withMargin = used + used * TASK_MONITOR_STACK_MARGIN_PERCENT / 100;
+  return (withMargin + TASK_MONITOR_STACK_ROUNDING - 1) / TASK_MONITOR_STACK_ROUNDING *
+         TASK_MONITOR_STACK_ROUNDING;
+}
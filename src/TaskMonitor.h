@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Tasks that can be watched at once
+#ifndef TASK_MONITOR_TASKS
+  #define TASK_MONITOR_TASKS 6
+#endif
+// Room for the state of every task in the system when sampling the CPU time, ESP-IDF alone runs
+// about a dozen
+#ifndef TASK_MONITOR_SYSTEM_TASKS
+  #define TASK_MONITOR_SYSTEM_TASKS 24
+#endif
+// Headroom on top of the most stack a task was seen using in the recommended stack size
+#ifndef TASK_MONITOR_STACK_MARGIN_PERCENT
+  #define TASK_MONITOR_STACK_MARGIN_PERCENT 25
+#endif
+// Recommended stack sizes are rounded up to this many bytes
+#ifndef TASK_MONITOR_STACK_ROUNDING
+  #define TASK_MONITOR_STACK_ROUNDING 256
+#endif
+// How often the stacks and CPU times are sampled when run as a scheduler job
+#ifndef TASK_MONITOR_INTERVAL_MS
+  #define TASK_MONITOR_INTERVAL_MS (30 * 1000)
+#endif
+// CPU time per task needs the FreeRTOS run time stats, only the stacks are watched without them
+#if defined(configGENERATE_RUN_TIME_STATS) && configGENERATE_RUN_TIME_STATS == 1 && \
+    defined(configUSE_TRACE_FACILITY) && configUSE_TRACE_FACILITY == 1
+  #define TASK_MONITOR_CPU 1
+#else
+  #define TASK_MONITOR_CPU 0
+#endif
+
+// Declares the stack and control block of a task started from a TaskDef, both are static so the
+// stacks show up in the link map instead of being taken from the heap at runtime
+#define TASK_STACK(name, bytes)                                                                  \
+  StackType_t name##Stack[(bytes) / sizeof(StackType_t)];                                        \
+  StaticTask_t name##Tcb
+// The TaskDef of the task with the stack declared by TASK_STACK(name, ...)
+#define TASK_DEF(name, function, priority, handle)                                               \
+  {function, #name, name##Stack, sizeof(name##Stack), &name##Tcb, priority, handle}
+
+// A row of the static task table, the stack and control block come from TASK_STACK().
+typedef struct TaskDef {
+  TaskFunction_t function;
+  const char *name;
+  StackType_t *stack;
+  uint32_t stackBytes;
+  StaticTask_t *tcb;
+  UBaseType_t priority;
+  // where the handle goes, may be nullptr
+  TaskHandle_t *handle;
+} TaskDef;
+
+typedef struct TaskUsage {
+  TaskHandle_t handle;
+  const char *name;
+  uint32_t stackBytes;
+  // least free stack seen since boot, i.e. the worst case so far
+  uint32_t minFreeBytes;
+  // share of the CPU in the last interval and the most in any interval since boot, in 1/10 %
+  uint16_t cpuPermille;
+  uint16_t peakCpuPermille;
+  uint32_t lastRunTime;
+} TaskUsage;
+
+/**
+ * Starts the tasks from a static table and keeps track of how much stack and CPU time each of them
+ * takes. sample() is cheap and doesn't block, it's meant to run as a scheduler job. report() logs
+ * the worst case since boot with a stack size that would have been enough for each task.
+ */
+class TaskMonitor {
+public:
+  // Creates the tasks with xTaskCreateStatic() and watches them, false if one couldn't be.
+  bool start(const TaskDef *tasks, uint8_t count);
+  // Watches a task created elsewhere, e.g. the timer service task.
+  bool watch(TaskHandle_t handle, uint32_t stackBytes);
+  void sample();
+  // A ScheduledFn for the TaskMonitor passed as context.
+  static void sampleJob(void *monitor) { ((TaskMonitor *)monitor)->sample(); }
+  void report();
+  uint8_t getTaskCount() { return _count; }
+  const TaskUsage *getUsage(uint8_t index) { return &_tasks[index]; }
+  // The stack size covering the worst case seen for a task plus TASK_MONITOR_STACK_MARGIN_PERCENT.
+  static uint32_t recommendStack(const TaskUsage &usage);
+
+private:
+  TaskUsage _tasks[TASK_MONITOR_TASKS] = {};
+  uint8_t _count = 0;
+#if TASK_MONITOR_CPU
+  TaskStatus_t _system[TASK_MONITOR_SYSTEM_TASKS];
+  uint32_t _lastTotalRunTime = 0;
+  void sampleCpu();
+#endif
+};
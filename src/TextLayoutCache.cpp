@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "TextLayoutCache.h"
+
+const TextLayout *TextLayoutCache::get(uint32_t fontId, uint16_t fontSize, uint32_t hash) {
+  for (Entry &entry : _entries) {
+    if (entry.used && entry.hash == hash && entry.fontSize == fontSize && entry.fontId == fontId) {
+      entry.lastUsed = ++_clock;
+      _stats.hits++;
+      return &entry.layout;
+    }
+  }
+  _stats.misses++;
+  return nullptr;
+}
+
+TextLayout *TextLayoutCache::put(uint32_t fontId, uint16_t fontSize, uint32_t hash) {
+  Entry *slot = nullptr;
+  for (Entry &entry : _entries) {
+    if (!entry.used) {
+      slot = &entry;
+      break;
+    }
+    if (!slot || entry.lastUsed < slot->lastUsed)
+      slot = &entry;
+  }
+  if (slot->used) {
+    _stats.evictions++;
+  } else {
+    _stats.entries++;
+  }
+  slot->used = true;
+  slot->fontId = fontId;
+  slot->fontSize = fontSize;
+  slot->hash = hash;
+  slot->lastUsed = ++_clock;
+  slot->layout = {};
+  return &slot->layout;
+}
+
+void TextLayoutCache::clear() {
+  for (Entry &entry : _entries) {
+    entry.used = false;
+  }
+  _stats.entries = 0;
+}
+
+TextLayoutCacheStats TextLayoutCache::getStats() {
+  return _stats;
+}
+
+uint32_t TextLayoutCache::hash(const char *str) {
+  uint32_t hash = 0x811C9DC5;
+  for (; *str; str++) {
+    hash = (hash ^ (uint8_t)*str) * 0x01000193;
+  }
+  return hash;
+}
+
+void TextLayoutCache::addInk(TextLayout *layout, int32_t left, int32_t top, uint16_t width,
+                             uint16_t height) {
+  if (width == 0 || height == 0)
+    return;
+  if (layout->width == 0) {
+    layout->left = left;
+    layout->top = top;
+    layout->width = width;
+    layout->height = height;
+    return;
+  }
+  int32_t right = layout->left + layout->width;
+  int32_t bottom = layout->top + layout->height;
+  right = left + width > right ? left + width : right;
+  bottom = top + height > bottom ? top + height : bottom;
+  layout->left = left < layout->left ? left : layout->left;
+  layout->top = top < layout->top ? top : layout->top;
+  layout->width = right - layout->left;
+  layout->height = bottom - layout->top;
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+
+// One repaint measures about 30 different strings
+#ifndef TEXT_LAYOUT_CACHE_ENTRIES
+  #define TEXT_LAYOUT_CACHE_ENTRIES 64
+#endif
+
+typedef struct TextLayoutCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint16_t entries;
+} TextLayoutCacheStats;
+
+// Size of a string relative to where drawString() draws it: the pen advance and the bounding box
+// of the ink (width and height 0 for strings without ink, e.g. blanks).
+typedef struct TextLayout {
+  int32_t advance;
+  int16_t left;
+  int16_t top;
+  uint16_t width;
+  uint16_t height;
+} TextLayout;
+
+/**
+ * Measured strings keyed by (font, pixel size, string hash), so that centering or aligning a
+ * string that was drawn before doesn't walk its glyphs again. The least recently used entry is
+ * replaced when the cache is full.
+ */
+class TextLayoutCache {
+public:
+  // Returns the cached layout or nullptr on a miss (which is counted as such).
+  const TextLayout *get(uint32_t fontId, uint16_t fontSize, uint32_t hash);
+  // Returns the entry for the key, the caller fills it in.
+  TextLayout *put(uint32_t fontId, uint16_t fontSize, uint32_t hash);
+  void clear();
+  TextLayoutCacheStats getStats();
+  // 32-bit FNV-1a over the string's bytes. Strings whose hashes collide at the same font size are
+  // measured alike, which 32 bits make unlikely enough for the few dozen strings of the UI.
+  static uint32_t hash(const char *str);
+  // Grows the ink bounding box of layout to include a glyph's box, for the renderers measuring.
+  static void addInk(TextLayout *layout, int32_t left, int32_t top, uint16_t width,
+                     uint16_t height);
+
+private:
+  typedef struct Entry {
+    TextLayout layout;
+    uint32_t fontId;
+    uint32_t hash;
+    uint32_t lastUsed;
+    uint16_t fontSize;
+    bool used;
+  } Entry;
+
+  Entry _entries[TEXT_LAYOUT_CACHE_ENTRIES] = {};
+  uint32_t _clock = 0;
+  TextLayoutCacheStats _stats = {};
+};
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "TileRenderer.h"
+
+TileRenderer::TileRenderer(TFT_eSPI *tft, BandRenderer *bands) {
+  _tft = tft;
+  _bands = bands;
+}
+
+bool TileRenderer::begin() {
+  _columns = (_tft->width() + TILE_SIZE - 1) / TILE_SIZE;
+  _rows = (_tft->height() + TILE_SIZE - 1) / TILE_SIZE;
+  _hashes = (uint32_t *)calloc(_columns * _rows, sizeof(uint32_t));
+  if (!_hashes) {
+    log_e("Not enough memory for tile rendering.");
+    return false;
+  }
+  return true;
+}
+
+void TileRenderer::invalidate() {
+  _valid = false;
+}
+
+void TileRenderer::invalidate(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (!_hashes)
+    return;
+  int16_t x0 = x < 0 ? 0 : x;
+  int16_t y0 = y < 0 ? 0 : y;
+  int16_t x1 = x + w > _tft->width() ? _tft->width() : x + w;
+  int16_t y1 = y + h > _tft->height() ? _tft->height() : y + h;
+  for (int16_t row = y0 / TILE_SIZE; row * TILE_SIZE < y1; row++) {
+    for (int16_t column = x0 / TILE_SIZE; column * TILE_SIZE < x1; column++) {
+      // as likely to match the next frame as any other hash collision
+      _hashes[row * _columns + column] = 0;
+    }
+  }
+}
+
+void TileRenderer::render(BandDrawFn draw, void *context) {
+  if (!_hashes)
+    return;
+
+  _stats = {};
+  int16_t width = _tft->width();
+  int16_t height = _tft->height();
+  TFT_eSprite *sprite = _bands->sprite();
+  const uint16_t *pixels = (const uint16_t *)sprite->getPointer();
+
+  for (int16_t bandY = 0; bandY < height; bandY += BAND_HEIGHT) {
+    int16_t rows = height - bandY < BAND_HEIGHT ? height - bandY : BAND_HEIGHT;
+    ScreenRect band = {0, bandY, width, rows};
+    _bands->drawBand(band, draw, context);
+
+    for (uint16_t tileRow = 0; tileRow < BAND_HEIGHT / TILE_SIZE; tileRow++) {
+      int16_t y = bandY + tileRow * TILE_SIZE;
+      if (y >= height)
+        break;
+      uint16_t h = height - y < TILE_SIZE ? height - y : TILE_SIZE;
+      uint32_t *hashes = _hashes + (y / TILE_SIZE) * _columns;
+      int16_t runStart = -1;
+      for (uint16_t column = 0; column <= _columns; column++) {
+        bool changed = false;
+        if (column < _columns) {
+          uint16_t x = column * TILE_SIZE;
+          uint16_t w = width - x < TILE_SIZE ? width - x : TILE_SIZE;
+          uint32_t hash = hashTile(pixels + tileRow * TILE_SIZE * width + x, width, w, h);
+          changed = !_valid || hash != hashes[column];
+          hashes[column] = hash;
+          _stats.tiles++;
+          _stats.changed += changed;
+        }
+        if (changed && runStart < 0) {
+          runStart = column;
+        } else if (!changed && runStart >= 0) {
+          int16_t x = runStart * TILE_SIZE;
+          int16_t w = (column * TILE_SIZE > width ? width : column * TILE_SIZE) - x;
+          sprite->pushSprite(x, y, x, tileRow * TILE_SIZE, w, h);
+          _stats.pushes++;
+          runStart = -1;
+        }
+      }
+    }
+  }
+  _valid = true;
+  log_i("Tiles: %d of %d changed (%d hits), %d pushes", _stats.changed, _stats.tiles,
+        _stats.tiles - _stats.changed, _stats.pushes);
+}
+
+// FNV-1a over pixel pairs. A collision keeps a changed tile on screen unchanged until it changes
+// again, at 32 bits that's acceptable for a safety net.
+uint32_t TileRenderer::hashTile(const uint16_t *pixels, uint16_t stride, uint16_t w, uint16_t h) {
+  uint32_t hash = 2166136261UL;
+  for (uint16_t row = 0; row < h; row++) {
+    const uint16_t *p = pixels + row * stride;
+    for (uint16_t col = 0; col + 1 < w; col += 2) {
+      hash = (hash ^ (p[col] | ((uint32_t)p[col + 1] << 16))) * 16777619UL;
+    }
+    if (w & 1)
+      hash = (hash ^ p[w - 1]) * 16777619UL;
+  }
+  return hash;
+}
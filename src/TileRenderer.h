@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#include "BandRenderer.h"
+
+#define TILE_SIZE 16
+
+static_assert(BAND_HEIGHT % TILE_SIZE == 0, "bands must consist of whole tile rows");
+
+typedef struct TileStats {
+  uint16_t tiles;
+  uint16_t changed;
+  // runs of adjacent changed tiles go out as one window
+  uint16_t pushes;
+} TileStats;
+
+/**
+ * Off-screen rendering with tile diffing: the frame is drawn band by band (see BandRenderer), a hash
+ * is computed for every tile and only tiles whose hash differs from the previous frame are sent
+ * to the display. Lets naive full redraws cost only as much SPI traffic as what changed.
+ */
+class TileRenderer {
+public:
+  TileRenderer(TFT_eSPI *tft, BandRenderer *bands);
+  // Allocates the hash table, returns false if out of memory.
+  bool begin();
+  // Draws the complete frame and pushes the tiles which changed.
+  void render(BandDrawFn draw, void *context);
+  // Forgets the hashes, the next frame is pushed entirely.
+  void invalidate();
+  // Forgets the hashes of the tiles intersecting the rectangle, e.g. after drawing there directly.
+  void invalidate(int16_t x, int16_t y, int16_t w, int16_t h);
+  TileStats getLastFrameStats() { return _stats; }
+
+private:
+  TFT_eSPI *_tft;
+  BandRenderer *_bands;
+  uint16_t _columns = 0;
+  uint16_t _rows = 0;
+  uint32_t *_hashes = nullptr;
+  bool _valid = false;
+  TileStats _stats = {};
+  uint32_t hashTile(const uint16_t *pixels, uint16_t stride, uint16_t w, uint16_t h);
+};
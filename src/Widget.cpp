@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#include "Widget.h"
+
+Widget::Widget(int16_t x, int16_t y, int16_t w, int16_t h) {
+  _bounds = {x, y, w, h};
+}
+
+void Widget::addChild(Widget *child) {
+  if (_lastChild)
+    _lastChild->_nextSibling = child;
+  else
+    _firstChild = child;
+  _lastChild = child;
+}
+
+void Widget::update(const String &inputs) {
+  if (!_visible)
+    return;
+  // FNV-1a, collisions merely cost a skipped redraw of content that changed in the same update
+  uint32_t hash = 2166136261UL;
+  for (const char *c = inputs.c_str(); *c; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619UL;
+  }
+  if (hash != _inputsHash) {
+    _inputsHash = hash;
+    _dirty = true;
+  }
+}
+
+void Widget::invalidate() {
+  if (_visible)
+    _dirty = true;
+}
+
+void Widget::setVisible(bool visible) {
+  if (visible != _visible) {
+    _visible = visible;
+    // hiding clears the area
+    _dirty = true;
+  }
+}
+
+Compositor::Compositor(TFT_eSPI *tft, Widget *root, uint16_t background) {
+  _tft = tft;
+  _root = root;
+  _background = background;
+}
+
+void Compositor::setBandRenderer(BandRenderer *bands) {
+  _bands = bands;
+}
+
+void Compositor::setTileRenderer(TileRenderer *tiles) {
+  _tiles = tiles;
+}
+
+uint32_t Compositor::render() {
+  _regionCount = 0;
+  collectDirty(_root);
+  if (_regionCount == 0)
+    return 0;
+
+  if (_tiles) {
+    // the whole tree is drawn, the tile hashes decide what goes to the display
+    _tiles->render(paintBand, this);
+    TileStats tileStats = _tiles->getLastFrameStats();
+    _stats.frames++;
+    _stats.regions = tileStats.pushes;
+    _stats.pixels = tileStats.changed * TILE_SIZE * TILE_SIZE;
+    return _stats.pixels;
+  }
+
+  uint32_t pixels = 0;
+  for (uint8_t i = 0; i < _regionCount; i++) {
+    drawRegion(_regions[i]);
+    pixels += area(_regions[i]);
+  }
+  _stats.frames++;
+  _stats.regions = _regionCount;
+  _stats.pixels = pixels;
+  return pixels;
+}
+
+void Compositor::invalidateAll() {
+  invalidateTree(_root);
+  // whatever is on the display now, the next frame replaces all of it
+  if (_tiles)
+    _tiles->invalidate();
+}
+
+void Compositor::invalidateScreen(const ScreenRect &rect) {
+  // the region path redraws whatever is dirty, only the tile hashes remember the screen content
+  if (_tiles)
+    _tiles->invalidate(rect.x, rect.y, rect.w, rect.h);
+}
+
+void Compositor::invalidateTree(Widget *widget) {
+  if (!widget->_visible)
+    return;
+  widget->_dirty = true;
+  for (Widget *child = widget->_firstChild; child; child = child->_nextSibling) {
+    invalidateTree(child);
+  }
+}
+
+void Compositor::collectDirty(Widget *widget) {
+  if (!widget->_visible) {
+    // dirty only in the frame hiding it, which clears its area
+    if (widget->_dirty) {
+      addRegion(widget->_bounds);
+      widget->_dirty = false;
+    }
+    return;
+  }
+  if (widget->_dirty) {
+    addRegion(widget->_bounds);
+    widget->_dirty = false;
+  }
+  for (Widget *child = widget->_firstChild; child; child = child->_nextSibling) {
+    collectDirty(child);
+  }
+}
+
+void Compositor::addRegion(ScreenRect rect) {
+  rect = clipToScreen(rect);
+  if (rect.w <= 0 || rect.h <= 0)
+    return;
+  // merge with every region it overlaps or touches, the result may touch others in turn
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (uint8_t i = 0; i < _regionCount; i++) {
+      if (touches(_regions[i], rect)) {
+        rect = unite(_regions[i], rect);
+        _regions[i] = _regions[--_regionCount];
+        merged = true;
+        break;
+      }
+    }
+  }
+  if (_regionCount < COMPOSITOR_MAX_REGIONS) {
+    _regions[_regionCount++] = rect;
+    return;
+  }
+  // out of regions, grow the one that grows least
+  uint8_t best = 0;
+  uint32_t bestGrowth = UINT32_MAX;
+  for (uint8_t i = 0; i < _regionCount; i++) {
+    uint32_t growth = area(unite(_regions[i], rect)) - area(_regions[i]);
+    if (growth < bestGrowth) {
+      best = i;
+      bestGrowth = growth;
+    }
+  }
+  rect = unite(_regions[best], rect);
+  _regions[best] = _regions[--_regionCount];
+  addRegion(rect);
+}
+
+void Compositor::drawRegion(const ScreenRect &region) {
+  if (_bands) {
+    _bands->render(region, paintBand, this);
+    return;
+  }
+
+  // keep the coordinates absolute, the viewport only clips
+  _tft->setViewport(region.x, region.y, region.w, region.h, false);
+  Widget *start = findOpaqueCover(_root, region, nullptr);
+  if (!start)
+    _tft->fillRect(region.x, region.y, region.w, region.h, _background);
+  paintFrom(_root, region, &start, _tft);
+  _tft->resetViewport();
+}
+
+// The band is cleared already, widgets which don't overlap it aren't drawn at all.
+void Compositor::paintBand(void *context, TFT_eSPI *canvas, const ScreenRect &band) {
+  Compositor *compositor = (Compositor *)context;
+  Widget *start = compositor->findOpaqueCover(compositor->_root, band, nullptr);
+  compositor->paintFrom(compositor->_root, band, &start, canvas);
+}
+
+// The topmost visible opaque widget covering the entire region, everything drawn before it would
+// be overdrawn anyway.
+Widget *Compositor::findOpaqueCover(Widget *widget, const ScreenRect &region, Widget *found) {
+  if (!widget->_visible)
+    return found;
+  if (widget->isOpaque() && contains(widget->_bounds, region))
+    found = widget;
+  for (Widget *child = widget->_firstChild; child; child = child->_nextSibling) {
+    found = findOpaqueCover(child, region, found);
+  }
+  return found;
+}
+
+// Paints the widgets intersecting the region in tree order, skipping those before *start.
+void Compositor::paintFrom(Widget *widget, const ScreenRect &region, Widget **start,
+                           TFT_eSPI *canvas) {
+  if (!widget->_visible || !overlaps(widget->_bounds, region))
+    return;
+  if (*start == widget)
+    *start = nullptr;
+  if (!*start)
+    widget->paint(canvas);
+  for (Widget *child = widget->_firstChild; child; child = child->_nextSibling) {
+    paintFrom(child, region, start, canvas);
+  }
+}
+
+ScreenRect Compositor::clipToScreen(const ScreenRect &rect) {
+  int16_t x0 = rect.x < 0 ? 0 : rect.x;
+  int16_t y0 = rect.y < 0 ? 0 : rect.y;
+  int16_t x1 = rect.x + rect.w > _tft->width() ? _tft->width() : rect.x + rect.w;
+  int16_t y1 = rect.y + rect.h > _tft->height() ? _tft->height() : rect.y + rect.h;
+  return {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+ScreenRect Compositor::unite(const ScreenRect &a, const ScreenRect &b) {
+  int16_t x0 = a.x < b.x ? a.x : b.x;
+  int16_t y0 = a.y < b.y ? a.y : b.y;
+  int16_t x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  int16_t y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  return {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+// Touching rectangles count too, merging them costs nothing
+bool Compositor::touches(const ScreenRect &a, const ScreenRect &b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+bool Compositor::overlaps(const ScreenRect &a, const ScreenRect &b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+bool Compositor::contains(const ScreenRect &outer, const ScreenRect &inner) {
+  return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w &&
+         inner.y + inner.h <= outer.y + outer.h;
+}
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+#include "BandRenderer.h"
+#include "TileRenderer.h"
+
+// Dirty widgets are collected into at most this many regions per frame, overlapping or touching
+// rectangles are merged, if there are more the two closest are.
+#define COMPOSITOR_MAX_REGIONS 4
+
+typedef struct CompositorStats {
+  uint32_t frames;
+  // of the last frame that drew anything
+  uint8_t regions;
+  uint32_t pixels;
+} CompositorStats;
+
+/**
+ * Node of the retained widget tree. A widget remembers a hash of the inputs it was last rendered
+ * with (typically the text it shows) and only invalidates its rectangle if they change. Children
+ * are drawn after, i.e. on top of, their parent and must lie within their parent's bounds.
+ */
+class Widget {
+public:
+  Widget(int16_t x, int16_t y, int16_t w, int16_t h);
+  virtual ~Widget() {}
+  void addChild(Widget *child);
+  // Invalidates the widget if inputs differ from those of the previous call. Hidden widgets ignore
+  // updates and invalidation, showing them again redraws them.
+  void update(const String &inputs);
+  void invalidate();
+  // Hiding clears the widget's area in the next frame, after that it takes no part in rendering.
+  void setVisible(bool visible);
+  bool isVisible() { return _visible; }
+  bool isDirty() { return _dirty; }
+  ScreenRect bounds() { return _bounds; }
+  // Opaque widgets paint every pixel of their bounds, nothing behind them needs to be drawn.
+  virtual bool isOpaque() { return false; }
+  // Draws the widget into canvas, the display or an off-screen sprite, in display coordinates. The
+  // compositor clips to the area being redrawn and has cleared it unless an opaque widget covers it.
+  virtual void paint(TFT_eSPI *canvas) = 0;
+
+private:
+  friend class Compositor;
+  ScreenRect _bounds;
+  bool _dirty = true;
+  bool _visible = true;
+  uint32_t _inputsHash = 0;
+  Widget *_firstChild = nullptr;
+  Widget *_lastChild = nullptr;
+  Widget *_nextSibling = nullptr;
+};
+
+// Groups widgets, draws nothing itself. As the root of the tree it covers the whole screen.
+class Container : public Widget {
+public:
+  Container(int16_t x, int16_t y, int16_t w, int16_t h) : Widget(x, y, w, h) {}
+  void paint(TFT_eSPI *canvas) override {}
+};
+
+/**
+ * Redraws only what changed: collects the bounds of all dirty widgets into a few regions and
+ * repaints each region once, drawing just the widgets which intersect it, clipped to it. With a
+ * BandRenderer the regions are composed off-screen and each band is pushed once, without one the
+ * widgets draw onto the display directly.
+ */
+class Compositor {
+public:
+  Compositor(TFT_eSPI *tft, Widget *root, uint16_t background);
+  void setBandRenderer(BandRenderer *bands);
+  // Renders complete frames through the tile renderer instead, see TileRenderer.
+  void setTileRenderer(TileRenderer *tiles);
+  // Redraws the dirty regions, returns the number of pixels redrawn (0 if nothing was dirty).
+  uint32_t render();
+  void invalidateAll();
+  // Tells the compositor that rect was drawn to directly, i.e. outside of render().
+  void invalidateScreen(const ScreenRect &rect);
+  CompositorStats getStats() { return _stats; }
+
+private:
+  TFT_eSPI *_tft;
+  Widget *_root;
+  uint16_t _background;
+  BandRenderer *_bands = nullptr;
+  TileRenderer *_tiles = nullptr;
+  ScreenRect _regions[COMPOSITOR_MAX_REGIONS];
+  uint8_t _regionCount = 0;
+  CompositorStats _stats = {};
+  void collectDirty(Widget *widget);
+  void addRegion(ScreenRect rect);
+  void drawRegion(const ScreenRect &region);
+  Widget *findOpaqueCover(Widget *widget, const ScreenRect &region, Widget *found);
+  void paintFrom(Widget *widget, const ScreenRect &region, Widget **start, TFT_eSPI *canvas);
+  static void paintBand(void *context, TFT_eSPI *canvas, const ScreenRect &band);
+  void invalidateTree(Widget *widget);
+  ScreenRect clipToScreen(const ScreenRect &rect);
+  static ScreenRect unite(const ScreenRect &a, const ScreenRect &b);
+  static bool touches(const ScreenRect &a, const ScreenRect &b);
+  static bool overlaps(const ScreenRect &a, const ScreenRect &b);
+  static bool contains(const ScreenRect &outer, const ScreenRect &inner);
+  static uint32_t area(const ScreenRect &rect) { return (uint32_t)rect.w * rect.h; }
+};
@@ -9,8 +9,23 @@
 #include <Wire.h>
 #include <BH1750.h>
 
-#include "fonts/open-sans.h"
+// generated by tools/pio_fonts.py from the font chosen in platformio.ini
+#include "ui_font.h"
+// generated by tools/pio_fonts.py as well
+#include "ui_bitmap_font.h"
+#include "BandRenderer.h"
+#include "BitmapFontRender.h"
+#include "CachedFontRender.h"
+#include "CoopExecutor.h"
+#include "DigitClock.h"
 #include "GfxUi.h"
+#include "RenderQueue.h"
+#include "Scheduler.h"
+#include "SnapshotBuffer.h"
+#include "SpritePool.h"
+#include "TaskMonitor.h"
+#include "TileRenderer.h"
+#include "Widget.h"
 
 #include <JsonListener.h>
 #include <OpenWeatherMapCurrent.h>
@@ -28,12 +43,21 @@
 // ----------------------------------------------------------------------------
 // Globals
 // ----------------------------------------------------------------------------
-OpenFontRender ofr;
+OpenFontRender fontRender;
+// sizes not in the bitmap font go through the glyph cache, FreeType only rasterizes glyphs not seen
+// before
+CachedFontRender glyphRender = CachedFontRender(&fontRender);
+// all text is drawn from the pre-rasterized bitmap font where possible
+BitmapFontRender ofr = BitmapFontRender(&uiBitmapFont, &glyphRender);
 FT6236 ts = FT6236(TFT_HEIGHT, TFT_WIDTH);
 TFT_eSPI tft = TFT_eSPI();
-TFT_eSprite timeSprite = TFT_eSprite(&tft);
-TFT_eSprite lightSprite = TFT_eSprite(&tft);
-GfxUi ui = GfxUi(&tft, &ofr);
+// off-screen buffers for widgets painted onto the display directly, see paintTextOffscreen()
+SpritePool spritePool = SpritePool(&tft, SPRITE_POOL_BYTES);
+// white to black ramp of the TEXT_SPRITE_DEPTH sprites
+uint16_t textPalette[16];
+GfxUi ui = GfxUi(&tft, &fontRender);
+// the time is composed from pre-rasterized characters, a tick only pushes the changed digits
+DigitClock digitClock = DigitClock(&glyphRender, 64, UI_TIME_GLYPHS);
 
 // time management variables
 int updateIntervalMillis = UPDATE_INTERVAL_MINUTES * 60 * 1000;
@@ -45,32 +69,212 @@ int16_t currCondTop = 0;
 int16_t forecastCondTop = 130;
 int16_t astroCondTop = 235;
 
-String prevTimeStr;
-
-OpenWeatherMapCurrentData currentWeather;
-OpenWeatherMapForecastData forecasts[NUMBER_OF_FORECASTS];
+// written by the weather task while the render task shows the previous update
+SnapshotBuffer<WeatherSnapshot> weatherSnapshots;
 
 // ----------------------------------------------------------------------------
 // Function prototypes (declarations)
 // ----------------------------------------------------------------------------
-void drawAstro();
+void drawAstro(const SunMoonCalc::Result &result);
 void drawCurrentWeather();
-void drawForecast();
+void drawForecast(DayForecast *dayForecasts);
+void drawLightInformation(TFT_eSPI *canvas, const String &text, uint8_t depth = 16);
 void drawProgress(const char *text, int8_t percentage);
-void drawTimeAndDate(bool repaint);
-void drawTimeAndDateTask(void * parameter);
-String getWeatherIconName(uint16_t id, bool today);
+void drawSeparator(TFT_eSPI *canvas, uint16_t y);
+void drawTimeAndDate(TFT_eSPI *canvas, const String &time, const String &date,
+                     uint8_t depth = 16);
+String getWeatherIconName(const OpenWeatherMapCurrentData &currentWeather, uint16_t id,
+                          bool today);
 void initJpegDecoder();
 void initOpenFontRender();
 bool pushImageToTft(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 void syncTime();
+void tickClock(void *context);
+void renderTask(void * parameter);
+void renderPending();
+void logRenderStats();
 void repaint(void * parameter);
-void updateData(boolean updateProgressBar);
-bool repaintInProgress = true;
-bool drawTimeAndDateInProgress = false;
+bool updateCurrentWeather(WeatherSnapshot *weather, boolean updateProgressBar);
+bool updateForecast(WeatherSnapshot *weather, boolean updateProgressBar);
+// draw requests for renderTask(), the only task drawing to the display
+RenderQueue renderQueue;
+// wakes the weather and light tasks and ticks the clock on their deadlines
+Scheduler scheduler;
+TaskHandle_t repaintTaskHandle = nullptr;
+TaskHandle_t lightReadTaskHandle = nullptr;
+
+// ----------------------------------------------------------------------------
+// Widgets: each keeps what it shows and is only redrawn if that changed
+// ----------------------------------------------------------------------------
+// The weather update on screen, only valid in the render task after the first one came in
+const WeatherSnapshot &shownWeather() {
+  return *weatherSnapshots.current();
+}
+
+// Directs text and icons to canvas, the display or an off-screen sprite
+void useCanvas(TFT_eSPI *canvas) {
+  ofr.setDrawer(*canvas);
+  ui.setCanvas(canvas);
+}
+
+class CurrentWeatherWidget : public Widget {
+public:
+  CurrentWeatherWidget() : Widget(0, currCondTop, tft.width(), 125) {}
+  void refresh() {
+    const OpenWeatherMapCurrentData &currentWeather = shownWeather().current;
+    int windAngleIndex = round(currentWeather.windDeg * 8 / 360);
+    update(getWeatherIconName(currentWeather, currentWeather.weatherId, true) + "|" +
+           currentWeather.description +
+           "|" + String(currentWeather.temp, 1) + "|" + currentWeather.humidity + "|" +
+           currentWeather.pressure + "|" + windAngleIndex + "|" +
+           String(currentWeather.windSpeed, 0));
+  }
+  void paint(TFT_eSPI *canvas) override {
+    useCanvas(canvas);
+    drawCurrentWeather();
+    drawSeparator(canvas, 120+currCondTop);
+  }
+};
+
+class ForecastWidget : public Widget {
+public:
+  ForecastWidget() : Widget(0, forecastCondTop - 5, tft.width(), astroCondTop - forecastCondTop + 5) {}
+  void refresh() {
+    // copied, the snapshot is handed back to the weather task with the next update
+    memcpy(_dayForecasts, shownWeather().dayForecasts, sizeof(_dayForecasts));
+    String inputs;
+    for (int i = 0; i < NUMBER_OF_DAY_FORECASTS; i++) {
+      inputs += String(_dayForecasts[i].day) + "|" + String(_dayForecasts[i].minTemp, 0) + "|" +
+                String(_dayForecasts[i].maxTemp, 0) + "|" +
+                getWeatherIconName(shownWeather().current, _dayForecasts[i].conditionCode,
+                                   false) +
+                "|";
+    }
+    update(inputs);
+  }
+  void paint(TFT_eSPI *canvas) override {
+    useCanvas(canvas);
+    drawForecast(_dayForecasts);
+    drawSeparator(canvas, astroCondTop-5);
+  }
+
+private:
+  DayForecast _dayForecasts[NUMBER_OF_DAY_FORECASTS];
+};
+
+class AstroWidget : public Widget {
+public:
+  AstroWidget() : Widget(0, astroCondTop, tft.width(), tft.height() - astroCondTop) {}
+  void refresh() {
+    time_t tnow = time(nullptr);
+    struct tm nowTime;
+    struct tm *nowUtc = gmtime_r(&tnow, &nowTime);
+    const OpenWeatherMapCurrentData &currentWeather = shownWeather().current;
+    SunMoonCalc smCalc = SunMoonCalc(mkgmtime(nowUtc), currentWeather.lat, currentWeather.lon);
+    _result = smCalc.calculateSunAndMoonData();
+    update(String((long)_result.sun.rise) + "|" + String((long)_result.sun.set) + "|" +
+           String((long)_result.moon.rise) + "|" + String((long)_result.moon.set) + "|" +
+           String(_result.moon.illumination, 2) + "|" +
+           (_result.moon.age < LUNAR_MONTH / 2 ? "waxing" : "waning") + "|" +
+           (currentWeather.lat < 0 ? "S" : "N"));
+  }
+  void paint(TFT_eSPI *canvas) override {
+    useCanvas(canvas);
+    drawAstro(_result);
+  }
+
+private:
+  SunMoonCalc::Result _result;
+};
+
+// Paints a widget showing only white text on black into a pooled TEXT_SPRITE_DEPTH sprite with draw
+// and pushes that, rather than onto the display where it would flicker. Without room for the sprite
+// it goes in bands, false if not even that is possible.
+bool paintTextOffscreen(Widget *widget, BandDrawFn draw) {
+  return TEXT_SPRITE_DEPTH < 16
+             ? spritePool.render(widget->bounds(), draw, widget, 0, TEXT_SPRITE_DEPTH, textPalette)
+             : spritePool.render(widget->bounds(), draw, widget, TFT_BLACK);
+}
+
+class ClockWidget : public Widget {
+public:
+  ClockWidget()
+      : Widget(timeSpritePos.x, timeSpritePos.y + astroCondTop, timeSpritePos.width,
+               timeSpritePos.height) {}
+  void refresh() {
+    _time = getCurrentTimestamp(UI_TIME_FORMAT);
+    _date = WEEKDAYS[getCurrentWeekday()] + ", " + getCurrentTimestamp(UI_DATE_FORMAT);
+    // the time is kept current by tick(), only a new date repaints the widget
+    update(_date);
+  }
+  // Pushes the digits that changed since the last paint or tick straight to the display, the clock
+  // is on top of everything. Falls back to a repaint if the time can't be drawn that way. Returns
+  // true if anything was pushed.
+  bool tick() {
+    if (isDirty() || !isVisible())
+      return false;
+    int8_t pushed = digitClock.update(&tft, timeSpritePos.x + centerWidth,
+                                      timeSpritePos.y + astroCondTop - 15, _time.c_str());
+    if (pushed < 0)
+      invalidate();
+    return pushed > 0;
+  }
+  // the sprite covers the whole widget
+  bool isOpaque() override { return true; }
+  void paint(TFT_eSPI *canvas) override {
+    if (canvas != &tft || !paintTextOffscreen(this, paintSprite))
+      drawTimeAndDate(canvas, _time, _date);
+  }
+
+private:
+  static void paintSprite(void *context, TFT_eSPI *canvas, const ScreenRect &band) {
+    ClockWidget *widget = (ClockWidget *)context;
+    drawTimeAndDate(canvas, widget->_time, widget->_date, TEXT_SPRITE_DEPTH);
+  }
+  String _time;
+  String _date;
+};
+
+class LightWidget : public Widget {
+public:
+  LightWidget()
+      : Widget(lightSpritePos.x, lightSpritePos.y + currCondTop, lightSpritePos.width,
+               lightSpritePos.height) {}
+  void refresh(float lux, uint32_t brightness) {
+    _text = String(lux, 1) + "/" + String(brightness);
+    update(_text);
+  }
+  bool isOpaque() override { return true; }
+  void paint(TFT_eSPI *canvas) override {
+    if (canvas != &tft || !paintTextOffscreen(this, paintSprite))
+      drawLightInformation(canvas, _text);
+  }
 
+private:
+  static void paintSprite(void *context, TFT_eSPI *canvas, const ScreenRect &band) {
+    LightWidget *widget = (LightWidget *)context;
+    drawLightInformation(canvas, widget->_text, TEXT_SPRITE_DEPTH);
+  }
+  String _text;
+};
+
+Container screen = Container(0, 0, tft.width(), tft.height());
+CurrentWeatherWidget currentWeatherWidget;
+LightWidget lightWidget;
+ForecastWidget forecastWidget;
+AstroWidget astroWidget;
+ClockWidget clockWidget;
+Compositor compositor = Compositor(&tft, &screen, TFT_BLACK);
+BandRenderer bandRenderer = BandRenderer(&tft, TFT_BLACK);
+#ifdef TILE_DIFF_RENDERING
+TileRenderer tileRenderer = TileRenderer(&tft, &bandRenderer);
+#endif
+
+void renderWidgets() {
+  compositor.render();
+  useCanvas(&tft);
+}
 
-int listUpdateIntervalMillis =  3 * 1000;
 typedef struct lightSettings {
   float minLight;
   float maxLight;
@@ -113,45 +317,132 @@ uint32_t getBrightness(float lux)
 
 BH1750 lightMeter;
 void lightReadTask(void * parameter);
-void drawLightInformation(float lux, uint32_t brightness);
+void sampleLight();
 
 void lightReadTask(void * parameter) 
 {
   while(1) {
-    if (!repaintInProgress && !drawTimeAndDateInProgress) {
-      float lux = lightMeter.readLightLevel();
-      if (lux > 40000.0) {
-        lightMeter.setMTreg(32);
-      } else if (lux > 10.0)
-      {
-        lightMeter.setMTreg(69);
-      } else if (lux <= 10.0)
-      {
-        lightMeter.setMTreg(138);
-      }
+    sampleLight();
+    // woken by the scheduler every LIGHT_SAMPLE_INTERVAL_MILLIS
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
 
-      const uint32_t brightness = getBrightness(lux);
-      setBrightness(brightness);
-      drawLightInformation(lux, brightness);
-    }
-    vTaskDelay(listUpdateIntervalMillis/portTICK_PERIOD_MS);
+// Adjusts the backlight to the ambient light and has the reading shown
+void sampleLight() {
+  float lux = lightMeter.readLightLevel();
+  if (lux > 40000.0) {
+    lightMeter.setMTreg(32);
+  } else if (lux > 10.0)
+  {
+    lightMeter.setMTreg(69);
+  } else if (lux <= 10.0)
+  {
+    lightMeter.setMTreg(138);
   }
+
+  const uint32_t brightness = getBrightness(lux);
+  setBrightness(brightness);
+  renderQueue.postLightReading(lux, brightness);
 }
 
-void drawLightInformation(float lux, uint32_t brightness)
+void drawLightInformation(TFT_eSPI *canvas, const String &text, uint8_t depth)
 {
-  lightSprite.fillSprite(TFT_BLACK);
-  ofr.setDrawer(lightSprite);
+  ofr.setDrawer(*canvas, depth);
 
   ofr.setFontSize(12);
-  String text = String(lux, 1) + "/"+String(brightness);
-  ofr.cdrawString(text.c_str(), lightSpritePos.width/2, 0);
+  ofr.cdrawString(text.c_str(), lightSpritePos.x+lightSpritePos.width/2,
+                  lightSpritePos.y+currCondTop);
 
-  lightSprite.pushSprite(lightSpritePos.x, lightSpritePos.y+currCondTop);
   ofr.setDrawer(tft);
 }
 
 
+// ----------------------------------------------------------------------------
+// Tasks: the stacks are static, the task monitor logs how much of each is used
+// ----------------------------------------------------------------------------
+// A weather update in steps of one blocking call each. The weather task runs them back to back,
+// in cooperative mode the display is drawn in between.
+class WeatherUpdate : public CoopJob {
+public:
+  // Returns false once the update is published, or abandoned because a fetch failed.
+  bool step() override {
+    switch (_step++) {
+    case 0:
+      if (_firstRun) renderQueue.postProgress("Starting WiFi...", 10);
+      if (WiFi.status() != WL_CONNECTED) {
+        startWiFi();
+      }
+      return true;
+    case 1:
+      if (_firstRun) renderQueue.postProgress("Synchronizing time...", 30);
+      syncTime();
+      return true;
+    case 2:
+      // parsing goes into a slot the render task doesn't read, the display keeps updating from the
+      // last complete snapshot meanwhile
+      _weather = weatherSnapshots.beginWrite();
+      _fetched = updateCurrentWeather(_weather, _firstRun);
+      return true;
+    case 3:
+      _fetched = _fetched && updateForecast(_weather, _firstRun);
+      return true;
+    default:
+      if (_fetched) {
+        if (_firstRun) renderQueue.postProgress("Ready", 100);
+        lastUpdateMillis = millis();
+        _weather->fetchedMillis = lastUpdateMillis;
+
+        weatherSnapshots.publish();
+        renderQueue.postWeather();
+        _firstRun = false;
+      } else {
+        // the slot isn't published, the next update writes it again
+        log_w("Weather update failed, keeping the last snapshot");
+      }
+      _step = 0;
+      return false;
+    }
+  }
+
+private:
+  uint8_t _step = 0;
+  bool _firstRun = true;
+  // whether everything fetched so far made it into _weather
+  bool _fetched = false;
+  WeatherSnapshot *_weather = nullptr;
+};
+WeatherUpdate weatherUpdate;
+
+#ifdef COOPERATIVE_TASKS
+// Runs the render, weather and light jobs on one task. They're only ever interrupted where a job
+// returns, so there's a single stack to pay for and nothing is drawn from two places at once.
+CoopExecutor executor;
+CallJob renderJob(renderPending);
+CallJob lightJob(sampleLight);
+
+void coopTask(void * parameter) {
+  executor.run();
+}
+
+// holds the weather update's parsing, the deepest of the jobs, and a frame
+TASK_STACK(coopTask, 12000);
+const TaskDef TASKS[] = {
+  TASK_DEF(coopTask, coopTask, 10, nullptr),
+};
+#else
+TASK_STACK(renderTask, 10000);
+TASK_STACK(repaintTask, 10000);
+TASK_STACK(lightReadTask, 10000);
+const TaskDef TASKS[] = {
+  // same priority as the weather task, they take turns while it parses
+  TASK_DEF(renderTask, renderTask, 10, nullptr),
+  TASK_DEF(repaintTask, repaint, 10, &repaintTaskHandle),
+  TASK_DEF(lightReadTask, lightReadTask, 5, &lightReadTaskHandle),
+};
+#endif
+TaskMonitor taskMonitor;
+
 // OneButton buttonOk(PIN_BUTTON_OK, false, false);
 
 // ----------------------------------------------------------------------------
@@ -191,45 +482,75 @@ void setup(void) {
   initTft(&tft);
   setBrightness(TFT_LED_BRIGHTNESS);
 
-  timeSprite.createSprite(timeSpritePos.width, timeSpritePos.height);
-  lightSprite.createSprite(lightSpritePos.width, lightSpritePos.height);
   // logDisplayDebugInfo(&tft);
 
   Wire.begin(PIN_SDA, PIN_SCL);
   lightMeter.begin();
 
   initFileSystem();
+  ui.begin();
   initOpenFontRender();
+  digitClock.begin(&tft, TFT_WHITE, TFT_BLACK);
+  // the atlas holds the clock's 64 px glyphs now, the arena their masks took in the glyph cache is
+  // freed and only allocated again for text the bitmap font doesn't cover
+  glyphRender.freeCache();
+  if (TEXT_SPRITE_DEPTH < 16)
+    spritePool.ramp(textPalette, TEXT_SPRITE_DEPTH, TFT_WHITE, TFT_BLACK);
+
+  screen.addChild(&currentWeatherWidget);
+  currentWeatherWidget.addChild(&lightWidget);
+  screen.addChild(&forecastWidget);
+  screen.addChild(&astroWidget);
+  screen.addChild(&clockWidget);
+  // the clock is shown in its place
+  astroWidget.setVisible(false);
+  // widgets are composed off-screen band by band, without the band sprite the clock and the light
+  // readout go through sprites from the pool to avoid flicker
+  if (bandRenderer.begin()) {
+    compositor.setBandRenderer(&bandRenderer);
+#ifdef TILE_DIFF_RENDERING
+    if (tileRenderer.begin()) {
+      compositor.setTileRenderer(&tileRenderer);
+    }
+#endif
+  }
 
-  xTaskCreate(
-    repaint,          /* Task function. */
-    "repaintTask",        /* String with name of task. */
-    10000,            /* Stack size in bytes. */
-    NULL,             /* Parameter passed as input of the task */
-    10,                /* Priority of the task. */
-    NULL);
-
-  xTaskCreate(
-    drawTimeAndDateTask,          /* Task function. */
-    "drawTimeAndDateTask",        /* String with name of task. */
-    10000,            /* Stack size in bytes. */
-    NULL,             /* Parameter passed as input of the task */
-    1,                /* Priority of the task. */
-    NULL);
-
-  xTaskCreate(
-    lightReadTask,          /* Task function. */
-    "lightReadTask",        /* String with name of task. */
-    10000,            /* Stack size in bytes. */
-    NULL,             /* Parameter passed as input of the task */
-    5,                /* Priority of the task. */
-    NULL);
+  renderQueue.begin();
+#ifdef COOPERATIVE_TASKS
+  // jobs added first get a turn between the steps of later ones. A post wakes the render job, so
+  // the queue is drained after every step and the jobs can't fill it and wait for themselves.
+  executor.add(&renderJob);
+  executor.add(&lightJob);
+  executor.add(&weatherUpdate);
+  renderQueue.setListener(CoopJob::wakeJob, &renderJob);
+  // both start right away like their tasks do
+  weatherUpdate.wake();
+  lightJob.wake();
+#endif
+  taskMonitor.start(TASKS, sizeof(TASKS) / sizeof(TASKS[0]));
+  // the scheduler's jobs run on its stack
+  taskMonitor.watch(xTimerGetTimerDaemonTaskHandle(),
+                    configTIMER_TASK_STACK_DEPTH * sizeof(StackType_t));
+
+  // the tasks sleep until their deadline, nothing wakes up just to check the time
+  const bool showsSeconds = strstr(UI_TIME_FORMAT, "%S") != nullptr;
+  scheduler.aligned("clock", showsSeconds ? 1000 : 60 * 1000, tickClock, nullptr);
+#ifdef COOPERATIVE_TASKS
+  scheduler.every("weather", updateIntervalMillis, CoopJob::wakeJob, &weatherUpdate);
+  scheduler.every("light", LIGHT_SAMPLE_INTERVAL_MILLIS, CoopJob::wakeJob, &lightJob);
+#else
+  scheduler.every("weather", updateIntervalMillis, Scheduler::notifyTask, repaintTaskHandle);
+  scheduler.every("light", LIGHT_SAMPLE_INTERVAL_MILLIS, Scheduler::notifyTask,
+                  lightReadTaskHandle);
+#endif
+  scheduler.every("tasks", TASK_MONITOR_INTERVAL_MS, TaskMonitor::sampleJob, &taskMonitor);
 }
 
 void loop(void) {
   // buttonOk.tick();
 
-  delay(1000);
+  // everything runs in the tasks started by setup(), don't wake up every second for nothing
+  vTaskDelete(NULL);
   
   // update if
   // - never (successfully) updated before OR
@@ -265,50 +586,46 @@ void loop(void) {
 // ----------------------------------------------------------------------------
 // Functions
 // ----------------------------------------------------------------------------
-void drawAstro() {
-  time_t tnow = time(nullptr);
-  struct tm *nowUtc = gmtime(&tnow);
-
-  SunMoonCalc smCalc = SunMoonCalc(mkgmtime(nowUtc), currentWeather.lat, currentWeather.lon);
-  const SunMoonCalc::Result result = smCalc.calculateSunAndMoonData();
-
+void drawAstro(const SunMoonCalc::Result &result) {
   ofr.setFontSize(18);
   ofr.cdrawString(SUN_MOON_LABEL[0].c_str(), 30, astroCondTop);
   ofr.cdrawString(SUN_MOON_LABEL[1].c_str(), tft.width() - 55, astroCondTop);
 
   ofr.setFontSize(14);
+  char timestamp[TIMESTAMP_LENGTH];
   // Sun
-  strftime(timestampBuffer, 26, UI_TIME_FORMAT_NO_SECONDS, localtime(&result.sun.rise));
-  ofr.cdrawString(timestampBuffer, 30, 20+astroCondTop);
+  formatLocalTime(timestamp, sizeof(timestamp), UI_TIME_FORMAT_NO_SECONDS, result.sun.rise);
+  ofr.cdrawString(timestamp, 30, 20+astroCondTop);
   
-  strftime(timestampBuffer, 26, UI_TIME_FORMAT_NO_SECONDS, localtime(&result.sun.set));
-  ofr.cdrawString(timestampBuffer, 30, 35+astroCondTop);
+  formatLocalTime(timestamp, sizeof(timestamp), UI_TIME_FORMAT_NO_SECONDS, result.sun.set);
+  ofr.cdrawString(timestamp, 30, 35+astroCondTop);
 
   // Moon
-  strftime(timestampBuffer, 26, UI_TIME_FORMAT_NO_SECONDS, localtime(&result.moon.rise));
-  ofr.cdrawString(timestampBuffer, tft.width() - 55, 20+astroCondTop);
-  strftime(timestampBuffer, 26, UI_TIME_FORMAT_NO_SECONDS, localtime(&result.moon.set));
-  ofr.cdrawString(timestampBuffer, tft.width() - 55, 35+astroCondTop);
+  formatLocalTime(timestamp, sizeof(timestamp), UI_TIME_FORMAT_NO_SECONDS, result.moon.rise);
+  ofr.cdrawString(timestamp, tft.width() - 55, 20+astroCondTop);
+  formatLocalTime(timestamp, sizeof(timestamp), UI_TIME_FORMAT_NO_SECONDS, result.moon.set);
+  ofr.cdrawString(timestamp, tft.width() - 55, 35+astroCondTop);
 
   // Moon icon
-  int imageIndex = round(result.moon.age * NUMBER_OF_MOON_IMAGES / LUNAR_MONTH);
-  if (imageIndex == NUMBER_OF_MOON_IMAGES) imageIndex = NUMBER_OF_MOON_IMAGES - 1;
-  ui.drawBmp("/moon/m-phase-" + String(imageIndex) + ".bmp", centerWidth - 37, 5+astroCondTop);
+  bool waxing = result.moon.age < LUNAR_MONTH / 2;
+  ui.drawMoon(centerWidth - 37, 5+astroCondTop, MOON_DIAMETER, result.moon.illumination, waxing,
+              shownWeather().current.lat < 0, MOON_ANTI_ALIASED);
 
   // ofr.setFontSize(12);
   // ofr.cdrawString(MOON_PHASES[result.moon.phase.index].c_str(), centerWidth, 40+astroCondTop);
 
-  log_i("Moon phase: %s, illumination: %f, age: %f -> image index: %d",
-        result.moon.phase.name.c_str(), result.moon.illumination, result.moon.age, imageIndex);
+  log_i("Moon phase: %s, illumination: %f, age: %f",
+        result.moon.phase.name.c_str(), result.moon.illumination, result.moon.age);
 }
 
 void drawCurrentWeather() {
+  const OpenWeatherMapCurrentData &currentWeather = shownWeather().current;
   // re-use variable throughout function
   String text = "";
 
   // icon
-  String weatherIcon = getWeatherIconName(currentWeather.weatherId, true);
-  ui.drawBmp("/weather/" + weatherIcon + ".bmp", 10, 30+currCondTop);
+  String weatherIcon = getWeatherIconName(currentWeather, currentWeather.weatherId, true);
+  ui.drawIcon("/weather/" + weatherIcon, 10, 30+currCondTop);
   // tft.drawRect(5, 125, 100, 100, 0x4228);
 
   // condition string
@@ -337,7 +654,7 @@ void drawCurrentWeather() {
   // wind rose icon
   int windAngleIndex = round(currentWeather.windDeg * 8 / 360);
   if (windAngleIndex > 7) windAngleIndex = 0;
-  ui.drawBmp("/wind/" + WIND_ICON_NAMES[windAngleIndex] + ".bmp", tft.width() - 60, 35+currCondTop);
+  ui.drawIcon("/wind/" + WIND_ICON_NAMES[windAngleIndex], tft.width() - 60, 35+currCondTop);
   // tft.drawRect(tft.width() - 80, 125, 75, 75, 0x4228);
 
   // wind speed
@@ -347,14 +664,7 @@ void drawCurrentWeather() {
   ofr.cdrawString(text.c_str(), tft.width() - 40, 90+currCondTop);
 }
 
-void drawForecast() {
-  DayForecast* dayForecasts = calculateDayForecasts(forecasts);
-  for (int i = 0; i < NUMBER_OF_DAY_FORECASTS; i++) {
-    log_i("[%d] condition code: %d, hour: %d, temp: %.1f/%.1f", dayForecasts[i].day,
-          dayForecasts[i].conditionCode, dayForecasts[i].conditionHour, dayForecasts[i].minTemp,
-          dayForecasts[i].maxTemp);
-  }
-
+void drawForecast(DayForecast *dayForecasts) {
   int widthEigth = tft.width() / 8;
   for (int i = 0; i < NUMBER_OF_DAY_FORECASTS; i++) {
     int x = widthEigth * ((i * 2) + 1);
@@ -362,7 +672,8 @@ void drawForecast() {
     ofr.cdrawString(WEEKDAYS_ABBR[dayForecasts[i].day].c_str(), x, forecastCondTop);
     ofr.setFontSize(16);
     ofr.cdrawString(String(String(dayForecasts[i].minTemp, 0) + "-" + String(dayForecasts[i].maxTemp, 0) + "°").c_str(), x, 25+forecastCondTop);
-    ui.drawBmp("/weather-small/" + getWeatherIconName(dayForecasts[i].conditionCode, false) + ".bmp", x - 25, 45+forecastCondTop);
+    String icon = getWeatherIconName(shownWeather().current, dayForecasts[i].conditionCode, false);
+    ui.drawIcon("/weather-small/" + icon, x - 25, 45+forecastCondTop);
   }
 }
 
@@ -378,50 +689,44 @@ void drawProgress(const char *text, int8_t percentage) {
   ui.drawProgressBar(pbX, pbY, pbWidth, 15, percentage, TFT_WHITE, TFT_TP_BLUE);
 }
 
-void drawSeparator(uint16_t y) {
-  tft.drawFastHLine(10, y, tft.width() - 2 * 15, 0x4228);
+void drawSeparator(TFT_eSPI *canvas, uint16_t y) {
+  canvas->drawFastHLine(10, y, tft.width() - 2 * 15, 0x4228);
 }
 
 
-void drawTimeAndDateTask(void * pvParameters) {
-  for(;;){
-    if (!repaintInProgress) {
-      drawTimeAndDate(false);
-    }
-    vTaskDelay(30*1000/portTICK_PERIOD_MS);
-  }
+// Scheduled right after each full minute, or second if the time shows them
+void tickClock(void *context) {
+  renderQueue.postClockTick();
 }
 
-void drawTimeAndDate(bool repaint) {
-  String currTimeStr = getCurrentTimestamp(UI_TIME_FORMAT);
-  if (repaint || !prevTimeStr || prevTimeStr != currTimeStr) {
-    drawTimeAndDateInProgress = true;
-    timeSprite.fillSprite(TFT_BLACK);
-    ofr.setDrawer(timeSprite);
+void drawTimeAndDate(TFT_eSPI *canvas, const String &time, const String &date,
+                     uint8_t depth) {
+  int16_t x0 = timeSpritePos.x;
+  int16_t y0 = timeSpritePos.y+astroCondTop;
+  ofr.setDrawer(*canvas, depth);
 
-    // Time
+  // Time
+  // centering that string would look optically odd for 12h times -> manage pos manually
+  if (!digitClock.draw(canvas, x0+centerWidth, y0-15, time.c_str(), depth)) {
     ofr.setFontSize(64);
-    // centering that string would look optically odd for 12h times -> manage pos manually
-    ofr.cdrawString(currTimeStr.c_str(), centerWidth, -15);
-    
-    // Date
-    ofr.setFontSize(12);
-    ofr.cdrawString(
-      String(WEEKDAYS[getCurrentWeekday()] + ", " + getCurrentTimestamp(UI_DATE_FORMAT)).c_str(),
-      centerWidth,
-      65
-      // TFT_DARKGREY
-    );
-
-    timeSprite.pushSprite(timeSpritePos.x, timeSpritePos.y+astroCondTop);
-    // set the drawer back since we temporarily changed it to the time sprite above
-    ofr.setDrawer(tft);
-    drawTimeAndDateInProgress = false;
-    prevTimeStr = currTimeStr;
+    ofr.cdrawString(time.c_str(), x0+centerWidth, y0-15);
   }
+
+  // Date
+  ofr.setFontSize(12);
+  ofr.cdrawString(
+    date.c_str(),
+    x0+centerWidth,
+    y0+65
+    // TFT_DARKGREY
+  );
+
+  // set the drawer back since we temporarily changed it to the canvas above
+  ofr.setDrawer(tft);
 }
 
-String getWeatherIconName(uint16_t id, bool today) {
+String getWeatherIconName(const OpenWeatherMapCurrentData &currentWeather, uint16_t id,
+                          bool today) {
   // Weather condition codes: https://openweathermap.org/weather-conditions#Weather-Condition-Codes-2
 
   // For the 8xx group we also have night versions of the icons.
@@ -467,7 +772,7 @@ void initJpegDecoder() {
 }
 
 void initOpenFontRender() {
-  ofr.loadFont(opensans, sizeof(opensans));
+  ofr.loadFont(uiFont, sizeof(uiFont));
   ofr.setDrawer(tft);
   ofr.setFontColor(TFT_WHITE);
   ofr.setBackgroundColor(TFT_BLACK);
@@ -476,16 +781,8 @@ void initOpenFontRender() {
 // Function will be called as a callback during decoding of a JPEG file to
 // render each block to the TFT.
 bool pushImageToTft(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap) {
-  // Stop further decoding as image is running off bottom of screen
-  if (y >= tft.height()) {
-    return 0;
-  }
-
-  // Automatically clips the image block rendering at the TFT boundaries.
-  tft.pushImage(x, y, w, h, bitmap);
-
-  // Return 1 to decode next block
-  return 1;
+  // Return true to decode next block, GfxUi double-buffers the blocks with DMA where available
+  return ui.pushJpegBlock(x, y, w, h, bitmap);
 }
 
 void syncTime() {
@@ -496,63 +793,159 @@ void syncTime() {
   }
 }
 
-void repaint(void * parameter) {
-  for(;;){
-    repaintInProgress = true;
-
-    tft.fillScreen(TFT_BLACK);
-    // ui.drawLogo();
-
-    ofr.setFontSize(14);
-    // ofr.cdrawString(APP_NAME, centerWidth, tft.height() - 50);
-    // ofr.cdrawString(VERSION, centerWidth, tft.height() - 30);
-
-    drawProgress("Starting WiFi...", 10);
-    if (WiFi.status() != WL_CONNECTED) {
-      startWiFi();
+// the progress screen is only shown until the first data is on screen, later updates redraw just
+// the widgets whose content changed
+bool progressShown = false;
+bool weatherShown = false;
+
+// Draws everything that piled up in the render queue as one frame
+void renderBatch(const RenderBatch &batch) {
+  if (batch.progress) {
+    if (!progressShown) {
+      tft.fillScreen(TFT_BLACK);
+      // ui.drawLogo();
+
+      // ofr.setFontSize(14);
+      // ofr.cdrawString(APP_NAME, centerWidth, tft.height() - 50);
+      // ofr.cdrawString(VERSION, centerWidth, tft.height() - 30);
+      progressShown = true;
     }
+    drawProgress(batch.progressText, batch.progressPercentage);
+  }
+  // lock-free, an update published while the previous one was still unseen replaces it
+  if (batch.weather && weatherSnapshots.acquire()) {
+    currentWeatherWidget.refresh();
+    forecastWidget.refresh();
+    // skips SunMoonCalc while the clock is shown in its place
+    if (astroWidget.isVisible())
+      astroWidget.refresh();
+    if (progressShown) {
+      // clears the progress screen
+      compositor.invalidateAll();
+      progressShown = false;
+    }
+    weatherShown = true;
+  }
+  if (batch.light) {
+    lightWidget.refresh(batch.lux, batch.brightness);
+  }
+  if (batch.clockTick || batch.weather) {
+    clockWidget.refresh();
+    if (clockWidget.tick()) {
+      // drawn past the compositor, the tile hashes of the clock are stale
+      compositor.invalidateScreen(clockWidget.bounds());
+    }
+  }
+  // nothing to show before the first data
+  if (!weatherShown)
+    return;
+  renderWidgets();
 
-    drawProgress("Synchronizing time...", 30);
-    syncTime();
-
-    updateData(true);
-
-    drawProgress("Ready", 100);
-    lastUpdateMillis = millis();
-
-    tft.fillScreen(TFT_BLACK);
-
-    drawCurrentWeather();
-    drawSeparator(120+currCondTop);
+  if (batch.weather) {
+    logRenderStats();
+  }
+}
 
-    drawForecast();
-    drawSeparator(astroCondTop-5);
+// Owns the display and the font renderers, all drawing happens here. The other tasks post what
+// changed to the render queue, everything that piled up while a frame was drawn goes into the next.
+void renderTask(void * parameter) {
+  RenderBatch batch;
+  for(;;){
+    renderQueue.receive(&batch);
+    renderBatch(batch);
+  }
+}
 
-    // drawAstro();
-    drawTimeAndDate(true);
+// The render task's work as a job, draws what is waiting without blocking on the queue
+void renderPending() {
+  RenderBatch batch;
+  if (renderQueue.receive(&batch, 0))
+    renderBatch(batch);
+}
 
-    repaintInProgress = false;
+void logRenderStats() {
+  CompositorStats compositorStats = compositor.getStats();
+  log_i("Compositor: %d regions, %d pixels redrawn in the last frame", compositorStats.regions,
+        compositorStats.pixels);
+  IconCacheStats cacheStats = ui.getIconCacheStats();
+  log_i("Icon cache: %d hits, %d misses, %d evictions, %zu/%zu bytes", cacheStats.hits,
+        cacheStats.misses, cacheStats.evictions, cacheStats.bytesUsed, cacheStats.bytesBudget);
+  GlyphCacheStats glyphStats = glyphRender.getStats();
+  log_i("Glyph cache: %d hits, %d misses, %d evictions, %d glyphs, %zu/%zu bytes",
+        glyphStats.hits, glyphStats.misses, glyphStats.evictions, glyphStats.entries,
+        glyphStats.bytesUsed, glyphStats.bytesBudget);
+  SpritePoolStats spriteStats = spritePool.getStats();
+  log_i("Sprite pool: %zu/%zu bytes peak, %d checkouts, %d reused, %d exhausted, %d banded, "
+        "%d failed", spriteStats.peakBytesAllocated, spriteStats.bytesBudget,
+        spriteStats.checkouts, spriteStats.reuses, spriteStats.exhausted, spriteStats.banded,
+        spriteStats.failed);
+  TextLayoutCacheStats layoutStats = ofr.getLayoutStats();
+  log_i("Text layout cache: %d hits, %d misses, %d evictions, %d strings", layoutStats.hits,
+        layoutStats.misses, layoutStats.evictions, layoutStats.entries);
+  RenderQueueStats queueStats = renderQueue.getStats();
+  log_i("Render queue: %d posted, %d dropped, %d frames, %d requests coalesced",
+        queueStats.posted, queueStats.dropped, queueStats.batches, queueStats.coalesced);
+  SchedulerStats schedulerStats = scheduler.getStats();
+  log_i("Scheduler: %d jobs, %d wakeups", schedulerStats.jobs, schedulerStats.fires);
+  taskMonitor.report();
+}
 
-    vTaskDelay(updateIntervalMillis/ portTICK_PERIOD_MS);
+// Fetches the weather data, the render task shows it. Parsing goes into a slot the render task
+// doesn't read, the display keeps updating from the last complete snapshot meanwhile.
+void repaint(void * parameter) {
+  for(;;){
+    while (weatherUpdate.step()) {
+    }
+    // woken by the scheduler every updateIntervalMillis counted from boot, however long the fetch
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
 }
 
-void updateData(boolean updateProgressBar) {
-  if(updateProgressBar) drawProgress("Updating weather...", 70);
+// Fills the current weather of weather, returns false if it couldn't be fetched.
+bool updateCurrentWeather(WeatherSnapshot *weather, boolean updateProgressBar) {
+  // the slot holds an older snapshot, nothing of it may leak into this one
+  *weather = WeatherSnapshot();
+  OpenWeatherMapCurrentData &currentWeather = weather->current;
+
+  if(updateProgressBar) renderQueue.postProgress("Updating weather...", 70);
   OpenWeatherMapCurrent *currentWeatherClient = new OpenWeatherMapCurrent();
   currentWeatherClient->setMetric(IS_METRIC);
   currentWeatherClient->setLanguage(OPEN_WEATHER_MAP_LANGUAGE);
   currentWeatherClient->updateCurrentById(&currentWeather, OPEN_WEATHER_MAP_API_KEY, OPEN_WEATHER_MAP_LOCATION_ID);
   delete currentWeatherClient;
   currentWeatherClient = nullptr;
-  log_i("Current weather in %s: %s, %.1f°", currentWeather.cityName, currentWeather.description.c_str(), currentWeather.feelsLike);
+  if (currentWeather.observationTime == 0) {
+    log_e("Current weather couldn't be fetched");
+    return false;
+  }
+  log_i("Current weather in %s: %s, %.1f°", currentWeather.cityName.c_str(),
+        currentWeather.description.c_str(), currentWeather.feelsLike);
+  return true;
+}
 
-  if(updateProgressBar) drawProgress("Updating forecast...", 90);
+// Fills the day forecasts of weather, returns false if no forecasts could be fetched.
+bool updateForecast(WeatherSnapshot *weather, boolean updateProgressBar) {
+  // parse buffer for the 3h forecasts, only the daily forecasts derived from it are published
+  static OpenWeatherMapForecastData forecasts[NUMBER_OF_FORECASTS];
+
+  if(updateProgressBar) renderQueue.postProgress("Updating forecast...", 90);
   OpenWeatherMapForecast *forecastClient = new OpenWeatherMapForecast();
   forecastClient->setMetric(IS_METRIC);
   forecastClient->setLanguage(OPEN_WEATHER_MAP_LANGUAGE);
   forecastClient->setAllowedHours(forecastHoursUtc, sizeof(forecastHoursUtc));
-  forecastClient->updateForecastsById(forecasts, OPEN_WEATHER_MAP_API_KEY, OPEN_WEATHER_MAP_LOCATION_ID, NUMBER_OF_FORECASTS);
+  uint8_t forecastCount = forecastClient->updateForecastsById(forecasts, OPEN_WEATHER_MAP_API_KEY, OPEN_WEATHER_MAP_LOCATION_ID, NUMBER_OF_FORECASTS);
   delete forecastClient;
   forecastClient = nullptr;
+  if (forecastCount == 0) {
+    log_e("Forecasts couldn't be fetched");
+    return false;
+  }
+
+  memcpy(weather->dayForecasts, calculateDayForecasts(forecasts), sizeof(weather->dayForecasts));
+  for (int i = 0; i < NUMBER_OF_DAY_FORECASTS; i++) {
+    DayForecast &day = weather->dayForecasts[i];
+    log_i("[%d] condition code: %d, hour: %d, temp: %.1f/%.1f", day.day, day.conditionCode,
+          day.conditionHour, day.minTemp, day.maxTemp);
+  }
+  return true;
 }
@@ -14,6 +14,8 @@ const char *WIFI_PWD = "purpleplum557";
 #define TIMEZONE "EET-2EEST,M3.5.0/3,M10.5.0/4"
 
 #define UPDATE_INTERVAL_MINUTES 10
+// how often the ambient light is measured to adjust the backlight
+#define LIGHT_SAMPLE_INTERVAL_MILLIS 3000
 
 // uncomment to get "08/23/2022 02:55:02 pm" instead of "23.08.2022 14:55:02"
 // #define DATE_TIME_FORMAT_US
@@ -70,14 +72,15 @@ typedef struct DayForecast {
   int day;
 } DayForecast;
 
-RectangleDef timeSpritePos = {0, 0, 320, 88};
+RectangleDef timeSpritePos = {0, 0, 240, 88};
 RectangleDef lightSpritePos = {10, 95, 70, 20};
 
 const String WIND_ICON_NAMES[] = {"N", "NE", "E", "SE", "S", "SW", "W", "NW"};
 
 // average approximation for the actual length of the synodic month
 const double LUNAR_MONTH = 29.530588853;
-const uint8_t NUMBER_OF_MOON_IMAGES = 32;
+const uint8_t MOON_DIAMETER = 50;
+const bool MOON_ANTI_ALIASED = true;
 
 // 2: portrait, on/off switch right side -> 0/0 top left
 // 3: landscape, on/off switch at the top -> 0/0 top left
@@ -102,6 +105,8 @@ const uint8_t NUMBER_OF_MOON_IMAGES = 32;
   #define UI_DATE_FORMAT "%m/%d/%Y"
   #define UI_TIME_FORMAT "%I:%M:%S %P"
   #define UI_TIME_FORMAT_NO_SECONDS "%I:%M %P"
+  // all characters UI_TIME_FORMAT produces, they're rasterized once for the clock
+  #define UI_TIME_GLYPHS "0123456789: amp"
   #define UI_TIMESTAMP_FORMAT (UI_DATE_FORMAT + " " + UI_TIME_FORMAT)
 #else
   int timePosX = 84;
@@ -109,6 +114,8 @@ const uint8_t NUMBER_OF_MOON_IMAGES = 32;
   // #define UI_TIME_FORMAT "%H:%M:%S"
   #define UI_TIME_FORMAT "%H:%M"
   #define UI_TIME_FORMAT_NO_SECONDS "%H:%M"
+  // all characters UI_TIME_FORMAT produces, they're rasterized once for the clock
+  #define UI_TIME_GLYPHS "0123456789:"
   #define UI_TIMESTAMP_FORMAT (UI_DATE_FORMAT + " " + UI_TIME_FORMAT)
 #endif
 
@@ -120,6 +127,13 @@ const uint8_t forecastHoursUtc[] = {0, 3, 6, 9, 12, 15, 18, 21};
 #define NUMBER_OF_FORECASTS 40
 #define NUMBER_OF_DAY_FORECASTS 4
 
+// Everything the screen shows from one weather update, never changed once published
+typedef struct WeatherSnapshot {
+  OpenWeatherMapCurrentData current;
+  DayForecast dayForecasts[NUMBER_OF_DAY_FORECASTS];
+  unsigned long fetchedMillis;
+} WeatherSnapshot;
+
 #define APP_NAME "ESP32 Weather Station Touch"
 #define VERSION "1.0.0"
 
@@ -6,7 +6,8 @@
 #include "time.h"
 #include "settings.h"
 
-char timestampBuffer[26];
+// Room for any of the timestamp formats in settings.h
+#define TIMESTAMP_LENGTH 26
 
 uint8_t getCurrentWeekday();
 
@@ -33,11 +34,14 @@ DayForecast* calculateDayForecasts(OpenWeatherMapForecastData *forecasts) {
   for (uint8_t i = 0; i < NUMBER_OF_FORECASTS; i++) {
     OpenWeatherMapForecastData forecast = forecasts[i];
     time_t forecastTimeUtc = forecast.observationTime;
-    struct tm *forecastLocalTime = localtime(&forecastTimeUtc);
+    struct tm forecastTime;
+    struct tm *forecastLocalTime = localtime_r(&forecastTimeUtc, &forecastTime);
 
     if (weekday == forecastLocalTime->tm_wday) {
-      strftime(timestampBuffer, sizeof(timestampBuffer), SYSTEM_TIMESTAMP_FORMAT, forecastLocalTime);
-      log_d("Skipping forecast for today %s", timestampBuffer);
+      char forecastTimestamp[TIMESTAMP_LENGTH];
+      strftime(forecastTimestamp, sizeof(forecastTimestamp), SYSTEM_TIMESTAMP_FORMAT,
+               forecastLocalTime);
+      log_d("Skipping forecast for today %s", forecastTimestamp);
       continue;
     }
 
@@ -73,8 +77,17 @@ String getCurrentTimestamp(const char* format) {
     log_e("Failed to obtain time.");
     return "";
   }
-  strftime(timestampBuffer, sizeof(timestampBuffer), format, &timeinfo);
-  return String(timestampBuffer);
+  // called from the weather and the render task, each formats into its own buffer
+  char timestamp[TIMESTAMP_LENGTH];
+  strftime(timestamp, sizeof(timestamp), format, &timeinfo);
+  return String(timestamp);
+}
+
+// Formats time as local time, localtime_r() keeps this safe to call from any task.
+void formatLocalTime(char *buffer, size_t size, const char *format, time_t time) {
+  struct tm timeinfo;
+  localtime_r(&time, &timeinfo);
+  strftime(buffer, size, format, &timeinfo);
 }
 
 boolean initTime() {
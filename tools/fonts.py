@@ -0,0 +1,634 @@
+# SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+# SPDX-License-Identifier: MIT
+
+"""Reduce the TrueType fonts embedded under src/fonts/ to the glyphs the UI can draw, and
+pre-rasterize them at the UI's font sizes.
+
+Can be used stand-alone or through tools/pio_fonts.py which runs it before every build:
+
+  python3 tools/fonts.py src/fonts/open-sans.h out/ui_font.h [extra glyphs]
+  python3 tools/fonts.py --bitmap src/fonts/open-sans.h out/ui_bitmap_font.h [extra glyphs]
+
+The glyphs kept are those of all string literals in src/settings.h and src/main.cpp, the
+characters text is assembled from at runtime (DEFAULT_EXTRA_GLYPHS) and the extra glyphs given.
+Only plain TrueType outlines (glyf) are supported, no CFF. Pure Python, no fontTools needed.
+"""
+
+import math
+import os
+import re
+import struct
+import sys
+import zlib
+
+# Numbers, units and the lowercase letters of the OpenWeatherMap descriptions (in English). "|" is
+# CACHED_FONT_REFERENCE_GLYPH in src/CachedFontRender.h.
+DEFAULT_EXTRA_GLYPHS = "0123456789 .,:;-+/%°|abcdefghijklmnopqrstuvwxyz"
+# Files whose string literals are scanned for glyphs
+STRING_SOURCES = ["src/settings.h", "src/main.cpp"]
+# Name of the array in the generated header
+ARRAY_NAME = "uiFont"
+# Pixel sizes (em height) of the bitmap font, those main.cpp passes to setFontSize()
+DEFAULT_BITMAP_SIZES = [12, 14, 16, 18, 22, 32, 64]
+# Name of the BitmapFont in the generated header and prefix of its arrays, see src/BitmapFont.h
+BITMAP_FONT_NAME = "uiBitmapFont"
+BITMAP_FONT_PREFIX = "UI_BITMAP_FONT"
+# Vertical samples per pixel row when rasterizing, horizontally coverage is exact
+SUBSAMPLES = 8
+# Maximum distance of the flattened outline from the curves, in pixels
+FLATNESS = 0.05
+
+# Tables copied as-is, besides the ones rewritten by subset(). Everything else (GSUB, GPOS, hdmx,
+# DSIG, ...) is dropped, FreeType doesn't need it for rendering.
+KEEP_TABLES = {b"head", b"hhea", b"maxp", b"OS/2", b"name", b"post", b"cvt ", b"fpgm", b"prep",
+               b"gasp"}
+
+# glyf composite flags
+ARG_1_AND_2_ARE_WORDS = 0x0001
+ARGS_ARE_XY_VALUES = 0x0002
+WE_HAVE_A_SCALE = 0x0008
+MORE_COMPONENTS = 0x0020
+WE_HAVE_AN_X_AND_Y_SCALE = 0x0040
+WE_HAVE_A_TWO_BY_TWO = 0x0080
+# glyf simple glyph flags
+ON_CURVE_POINT = 0x01
+X_SHORT_VECTOR = 0x02
+Y_SHORT_VECTOR = 0x04
+REPEAT_FLAG = 0x08
+X_IS_SAME = 0x10
+Y_IS_SAME = 0x20
+
+
+def read_font_header(path):
+  """Returns the bytes of the first array in a C header like src/fonts/open-sans.h."""
+  with open(path, encoding="utf-8") as f:
+    text = f.read()
+  # the comments may list "{|}" among the glyphs
+  start = text.index("= {") + 3
+  body = text[start:text.index("};", start)]
+  return bytes(int(v, 16) for v in re.findall(r"0x[0-9a-fA-F]{2}", body))
+
+
+def string_glyphs(paths):
+  """All characters of the string literals in the given sources, escapes resolved."""
+  chars = set()
+  for path in paths:
+    if not os.path.isfile(path):
+      continue
+    with open(path, encoding="utf-8") as f:
+      for literal in re.findall(r'"((?:[^"\\\n]|\\.)*)"', f.read()):
+        # strftime and printf directives don't draw themselves
+        literal = re.sub(r"%[-0-9.]*[a-zA-Z]", "", literal)
+        chars.update(re.sub(r"\\(.)", lambda m: {"n": "\n", "t": "\t"}.get(m.group(1), m.group(1)),
+                            literal))
+  return chars
+
+
+def read_tables(font):
+  if struct.unpack_from(">I", font, 0)[0] != 0x00010000:
+    raise ValueError("not a TrueType font (CFF outlines aren't supported)")
+  count, = struct.unpack_from(">H", font, 4)
+  tables = {}
+  for i in range(count):
+    tag, _, offset, length = struct.unpack_from(">4sIII", font, 12 + 16 * i)
+    tables[tag] = font[offset:offset + length]
+  return tables
+
+
+def read_cmap(cmap):
+  """Codepoint -> glyph id from the Unicode subtables (formats 4 and 12)."""
+  mapping = {}
+  _, count = struct.unpack_from(">HH", cmap, 0)
+  for i in range(count):
+    platform, encoding, offset = struct.unpack_from(">HHI", cmap, 4 + 8 * i)
+    if (platform, encoding) not in ((0, 3), (0, 4), (3, 1), (3, 10)):
+      continue
+    fmt, = struct.unpack_from(">H", cmap, offset)
+    if fmt == 4:
+      segments = struct.unpack_from(">H", cmap, offset + 6)[0] // 2
+      ends = offset + 14
+      starts = ends + 2 * segments + 2
+      deltas = starts + 2 * segments
+      range_offsets = deltas + 2 * segments
+      for s in range(segments):
+        end, = struct.unpack_from(">H", cmap, ends + 2 * s)
+        start, = struct.unpack_from(">H", cmap, starts + 2 * s)
+        delta, = struct.unpack_from(">h", cmap, deltas + 2 * s)
+        range_offset, = struct.unpack_from(">H", cmap, range_offsets + 2 * s)
+        for c in range(start, end + 1):
+          if c == 0xFFFF:
+            continue
+          if range_offset == 0:
+            gid = (c + delta) & 0xFFFF
+          else:
+            gid, = struct.unpack_from(">H", cmap, range_offsets + 2 * s + range_offset +
+                                      2 * (c - start))
+            gid = (gid + delta) & 0xFFFF if gid else 0
+          if gid:
+            mapping.setdefault(c, gid)
+    elif fmt == 12:
+      groups, = struct.unpack_from(">I", cmap, offset + 12)
+      for g in range(groups):
+        start, end, gid = struct.unpack_from(">III", cmap, offset + 16 + 12 * g)
+        for c in range(start, end + 1):
+          mapping.setdefault(c, gid + c - start)
+  return mapping
+
+
+def glyph_data(tables):
+  """List of the glyf entries, indexed by glyph id."""
+  long_loca = struct.unpack_from(">h", tables[b"head"], 50)[0] == 1
+  num_glyphs, = struct.unpack_from(">H", tables[b"maxp"], 4)
+  loca = tables[b"loca"]
+  if long_loca:
+    offsets = struct.unpack_from(">%dI" % (num_glyphs + 1), loca)
+  else:
+    offsets = [o * 2 for o in struct.unpack_from(">%dH" % (num_glyphs + 1), loca)]
+  glyf = tables[b"glyf"]
+  return [glyf[offsets[i]:offsets[i + 1]] for i in range(num_glyphs)]
+
+
+def components(glyph):
+  """(offset of the glyph id, glyph id) of every component of a composite glyph."""
+  if len(glyph) < 10 or struct.unpack_from(">h", glyph, 0)[0] >= 0:
+    return []
+  result = []
+  pos = 10
+  while True:
+    flags, gid = struct.unpack_from(">HH", glyph, pos)
+    result.append((pos + 2, gid))
+    pos += 4 + (4 if flags & ARG_1_AND_2_ARE_WORDS else 2)
+    if flags & WE_HAVE_A_SCALE:
+      pos += 2
+    elif flags & WE_HAVE_AN_X_AND_Y_SCALE:
+      pos += 4
+    elif flags & WE_HAVE_A_TWO_BY_TWO:
+      pos += 8
+    if not flags & MORE_COMPONENTS:
+      return result
+
+
+def build_cmap(mapping):
+  """A format 4 cmap for the BMP codepoints in mapping (codepoint -> new glyph id)."""
+  codes = sorted(c for c in mapping if c < 0xFFFF)
+  # segments of consecutive codepoints with consecutive glyph ids, one idDelta each
+  segments = []
+  for c in codes:
+    if segments and segments[-1][1] == c - 1 and \
+        mapping[c] - c == mapping[segments[-1][0]] - segments[-1][0]:
+      segments[-1][1] = c
+    else:
+      segments.append([c, c])
+  segments.append([0xFFFF, 0xFFFF])
+  n = len(segments)
+  search = 2 ** (n.bit_length() - 1)
+  sub = struct.pack(">HHHHHHH", 4, 16 + 8 * n, 0, 2 * n, 2 * search, search.bit_length() - 1,
+                    2 * n - 2 * search)
+  sub += struct.pack(">%dH" % n, *(end for _, end in segments)) + b"\0\0"
+  sub += struct.pack(">%dH" % n, *(start for start, _ in segments))
+  sub += struct.pack(">%dh" % n, *(((mapping[s] - s + 0x8000) & 0xFFFF) - 0x8000
+                                   if s != 0xFFFF else 1 for s, _ in segments))
+  sub += struct.pack(">%dH" % n, *([0] * n))
+  return struct.pack(">HHHHIHHI", 0, 2, 0, 3, 20, 3, 1, 20) + sub
+
+
+def checksum(data):
+  data += b"\0" * (-len(data) % 4)
+  return sum(struct.unpack(">%dI" % (len(data) // 4), data)) & 0xFFFFFFFF
+
+
+def build_font(tables):
+  head = bytearray(tables[b"head"])
+  struct.pack_into(">I", head, 8, 0)
+  tables = {**tables, b"head": bytes(head)}
+  tags = sorted(tables)
+  n = len(tags)
+  search = 2 ** (n.bit_length() - 1)
+  header = struct.pack(">IHHHH", 0x00010000, n, search * 16, search.bit_length() - 1,
+                       n * 16 - search * 16)
+  offset = 12 + 16 * n
+  directory = b""
+  body = b""
+  for tag in tags:
+    data = tables[tag]
+    directory += struct.pack(">4sIII", tag, checksum(data), offset + len(body), len(data))
+    body += data + b"\0" * (-len(data) % 4)
+  font = bytearray(header + directory + body)
+  # head.checkSumAdjustment over the whole font
+  head_offset = struct.unpack_from(">I", directory, 16 * tags.index(b"head") + 8)[0]
+  struct.pack_into(">I", font, head_offset + 8, (0xB1B0AFBA - checksum(bytes(font))) & 0xFFFFFFFF)
+  return bytes(font)
+
+
+def subset(font, chars):
+  """Returns a TrueType font with only the glyphs of chars (and the components they use)."""
+  tables = read_tables(font)
+  cmap = read_cmap(tables[b"cmap"])
+  glyphs = glyph_data(tables)
+  keep = {0} | {cmap[ord(c)] for c in chars if ord(c) in cmap}
+  pending = list(keep)
+  while pending:
+    for _, gid in components(glyphs[pending.pop()]):
+      if gid not in keep:
+        keep.add(gid)
+        pending.append(gid)
+  old_ids = sorted(keep)
+  new_id = {old: new for new, old in enumerate(old_ids)}
+
+  glyf = b""
+  loca = []
+  for old in old_ids:
+    glyph = bytearray(glyphs[old])
+    for pos, gid in components(glyphs[old]):
+      struct.pack_into(">H", glyph, pos, new_id[gid])
+    loca.append(len(glyf))
+    glyf += bytes(glyph) + b"\0" * (len(glyph) % 2)
+  loca.append(len(glyf))
+  short_loca = loca[-1] < 0x20000
+
+  hhea = bytearray(tables[b"hhea"])
+  metrics_count, = struct.unpack_from(">H", hhea, 34)
+  hmtx = tables[b"hmtx"]
+  metrics = []
+  for old in old_ids:
+    if old < metrics_count:
+      metrics.append(struct.unpack_from(">Hh", hmtx, 4 * old))
+    else:
+      advance, = struct.unpack_from(">H", hmtx, 4 * (metrics_count - 1))
+      lsb, = struct.unpack_from(">h", hmtx, 4 * metrics_count + 2 * (old - metrics_count))
+      metrics.append((advance, lsb))
+  struct.pack_into(">H", hhea, 34, len(old_ids))
+
+  head = bytearray(tables[b"head"])
+  struct.pack_into(">h", head, 50, 0 if short_loca else 1)
+  maxp = bytearray(tables[b"maxp"])
+  struct.pack_into(">H", maxp, 4, len(old_ids))
+  # version 3: no glyph names
+  post = bytearray(tables[b"post"][:32])
+  struct.pack_into(">I", post, 0, 0x00030000)
+
+  mapping = {ord(c): new_id[cmap[ord(c)]] for c in chars if ord(c) in cmap}
+  result = {tag: data for tag, data in tables.items() if tag in KEEP_TABLES}
+  if b"OS/2" in result and mapping:
+    os2 = bytearray(result[b"OS/2"])
+    struct.pack_into(">HH", os2, 64, min(min(mapping), 0xFFFF), min(max(mapping), 0xFFFF))
+    result[b"OS/2"] = bytes(os2)
+  result.update({
+    b"head": bytes(head), b"hhea": bytes(hhea), b"maxp": bytes(maxp), b"post": bytes(post),
+    b"cmap": build_cmap(mapping), b"glyf": glyf,
+    b"loca": struct.pack(">%d%s" % (len(loca), "H" if short_loca else "I"),
+                         *(o // 2 if short_loca else o for o in loca)),
+    b"hmtx": b"".join(struct.pack(">Hh", *m) for m in metrics),
+  })
+  if b"kern" in tables:
+    kern = subset_kern(tables[b"kern"], new_id)
+    if kern:
+      result[b"kern"] = kern
+  return build_font(result)
+
+
+def subset_kern(kern, new_id):
+  """Keeps the pairs of retained glyphs from a version 0, format 0 kern table."""
+  version, count = struct.unpack_from(">HH", kern, 0)
+  if version != 0 or count < 1:
+    return None
+  _, length, coverage = struct.unpack_from(">HHH", kern, 4)
+  if coverage >> 8 != 0:
+    return None
+  pairs_count, = struct.unpack_from(">H", kern, 10)
+  pairs = []
+  for i in range(pairs_count):
+    left, right, value = struct.unpack_from(">HHh", kern, 18 + 6 * i)
+    if left in new_id and right in new_id:
+      pairs.append((new_id[left], new_id[right], value))
+  if not pairs:
+    return None
+  pairs.sort()
+  n = len(pairs)
+  search = 2 ** (n.bit_length() - 1)
+  sub = struct.pack(">HHHHHHH", 0, 14 + 6 * n, coverage, n, search * 6, search.bit_length() - 1,
+                    (n - search) * 6)
+  sub += b"".join(struct.pack(">HHh", *p) for p in pairs)
+  return struct.pack(">HH", 0, 1) + sub
+
+
+def simple_contours(glyph, count):
+  """Contours of a simple glyph as lists of (x, y, on curve) in font units."""
+  ends = struct.unpack_from(">%dH" % count, glyph, 10)
+  points = ends[-1] + 1 if count else 0
+  pos = 10 + 2 * count
+  pos += 2 + struct.unpack_from(">H", glyph, pos)[0]
+  flags = []
+  while len(flags) < points:
+    flag = glyph[pos]
+    pos += 1
+    flags.append(flag)
+    if flag & REPEAT_FLAG:
+      flags += [flag] * glyph[pos]
+      pos += 1
+  coordinates = []
+  for short, same in ((X_SHORT_VECTOR, X_IS_SAME), (Y_SHORT_VECTOR, Y_IS_SAME)):
+    values = []
+    value = 0
+    for flag in flags[:points]:
+      if flag & short:
+        value += glyph[pos] if flag & same else -glyph[pos]
+        pos += 1
+      elif not flag & same:
+        value += struct.unpack_from(">h", glyph, pos)[0]
+        pos += 2
+      values.append(value)
+    coordinates.append(values)
+  contours = []
+  start = 0
+  for end in ends:
+    contours.append([(coordinates[0][i], coordinates[1][i], bool(flags[i] & ON_CURVE_POINT))
+                     for i in range(start, end + 1)])
+    start = end + 1
+  return contours
+
+
+def glyph_contours(glyphs, gid):
+  """Contours of any glyph, composites resolved (components positioned by point matching aren't
+  supported and are placed at the origin)."""
+  glyph = glyphs[gid]
+  if len(glyph) < 10:
+    return []
+  count, = struct.unpack_from(">h", glyph, 0)
+  if count >= 0:
+    return simple_contours(glyph, count)
+  contours = []
+  pos = 10
+  while True:
+    flags, component = struct.unpack_from(">HH", glyph, pos)
+    pos += 4
+    if flags & ARG_1_AND_2_ARE_WORDS:
+      dx, dy = struct.unpack_from(">hh", glyph, pos)
+      pos += 4
+    else:
+      dx, dy = struct.unpack_from(">bb", glyph, pos)
+      pos += 2
+    if not flags & ARGS_ARE_XY_VALUES:
+      dx = dy = 0
+    a, b, c, d = 1.0, 0.0, 0.0, 1.0
+    if flags & WE_HAVE_A_SCALE:
+      a = d = struct.unpack_from(">h", glyph, pos)[0] / 16384
+      pos += 2
+    elif flags & WE_HAVE_AN_X_AND_Y_SCALE:
+      a, d = (v / 16384 for v in struct.unpack_from(">hh", glyph, pos))
+      pos += 4
+    elif flags & WE_HAVE_A_TWO_BY_TWO:
+      a, b, c, d = (v / 16384 for v in struct.unpack_from(">hhhh", glyph, pos))
+      pos += 8
+    for contour in glyph_contours(glyphs, component):
+      contours.append([(x * a + y * c + dx, x * b + y * d + dy, on) for x, y, on in contour])
+    if not flags & MORE_COMPONENTS:
+      return contours
+
+
+def flatten(contour, transform):
+  """Closed polygon approximating a contour, points transformed to pixels by transform."""
+  points = [transform(x, y) + (on,) for x, y, on in contour]
+  if not any(on for _, _, on in points):
+    # all points off the curve: start on the implied point between the last and the first
+    (x0, y0, _), (x1, y1, _) = points[-1], points[0]
+    points.insert(0, ((x0 + x1) / 2, (y0 + y1) / 2, True))
+  else:
+    first = next(i for i, p in enumerate(points) if p[2])
+    points = points[first:] + points[:first]
+
+  polygon = [points[0][:2]]
+  control = None
+
+  def curve(end):
+    (x0, y0), (cx, cy), (x1, y1) = polygon[-1], control, end
+    deviation = math.hypot(x0 - 2 * cx + x1, y0 - 2 * cy + y1)
+    steps = max(1, math.ceil(math.sqrt(deviation / (8 * FLATNESS))))
+    for i in range(1, steps + 1):
+      t = i / steps
+      u = 1 - t
+      polygon.append((u * u * x0 + 2 * u * t * cx + t * t * x1,
+                      u * u * y0 + 2 * u * t * cy + t * t * y1))
+
+  for x, y, on in points[1:] + points[:1]:
+    if on:
+      if control:
+        curve((x, y))
+        control = None
+      else:
+        polygon.append((x, y))
+    elif control:
+      # two off-curve points imply an on-curve point halfway between them
+      curve(((control[0] + x) / 2, (control[1] + y) / 2))
+      control = (x, y)
+    else:
+      control = (x, y)
+  return polygon
+
+
+def rasterize(polygons):
+  """Anti-aliased coverage of the polygons (non-zero winding), returns left, top, width, height
+  and width x height 4 bit alpha values, top-down."""
+  points = [p for polygon in polygons for p in polygon]
+  if not points:
+    return 0, 0, 0, 0, []
+  left = math.floor(min(x for x, _ in points))
+  top = math.floor(min(y for _, y in points))
+  width = math.ceil(max(x for x, _ in points)) - left
+  height = math.ceil(max(y for _, y in points)) - top
+  # edges bucketed by the pixel rows they cross
+  rows = [[] for _ in range(height)]
+  for polygon in polygons:
+    for (x0, y0), (x1, y1) in zip(polygon, polygon[1:] + polygon[:1]):
+      if y0 == y1:
+        continue
+      edge = (x0 - left, y0 - top, x1 - left, y1 - top)
+      for row in range(max(0, math.floor(min(edge[1], edge[3]))),
+                       min(height, math.ceil(max(edge[1], edge[3])))):
+        rows[row].append(edge)
+
+  coverage = [0.0] * (width * height)
+  for row in range(height):
+    for sample in range(SUBSAMPLES):
+      y = row + (sample + 0.5) / SUBSAMPLES
+      crossings = sorted((x0 + (y - y0) * (x1 - x0) / (y1 - y0), 1 if y1 > y0 else -1)
+                         for x0, y0, x1, y1 in rows[row] if min(y0, y1) <= y < max(y0, y1))
+      winding = 0
+      for i, (x, direction) in enumerate(crossings):
+        if winding:
+          span_start = crossings[i - 1][0]
+          for col in range(max(0, math.floor(span_start)), min(width, math.ceil(x))):
+            coverage[row * width + col] += (min(x, col + 1) - max(span_start, col)) / SUBSAMPLES
+        winding += direction
+  return left, top, width, height, [min(15, int(c * 15 + 0.5)) for c in coverage]
+
+
+def ascender(tables):
+  """Like FreeType: from hhea, from OS/2 if that's 0 (typographic, then Windows ascent)."""
+  value, = struct.unpack_from(">h", tables[b"hhea"], 4)
+  if value == 0 and b"OS/2" in tables:
+    typo, _, _, win = struct.unpack_from(">hhhH", tables[b"OS/2"], 68)
+    value = typo or win
+  return value
+
+
+def horizontal_metrics(tables, gid):
+  hmtx = tables[b"hmtx"]
+  count, = struct.unpack_from(">H", tables[b"hhea"], 34)
+  return struct.unpack_from(">H", hmtx, 4 * min(gid, count - 1))[0]
+
+
+def kerning_pairs(tables):
+  """(left glyph id, right glyph id) -> value in font units from a version 0 kern table."""
+  kern = tables.get(b"kern")
+  if not kern or struct.unpack_from(">H", kern, 0)[0] != 0:
+    return {}
+  _, _, coverage, pairs_count = struct.unpack_from(">HHHH", kern, 4)
+  if coverage >> 8 != 0:
+    return {}
+  pairs = {}
+  for i in range(pairs_count):
+    left, right, value = struct.unpack_from(">HHh", kern, 18 + 6 * i)
+    pairs[(left, right)] = value
+  return pairs
+
+
+def bitmap_font(font, chars, sizes):
+  """Rasterizes chars at the pixel sizes, see src/BitmapFont.h for the layout. Returns the
+  codepoints, the packed alpha values and per size (size, glyphs, kerning)."""
+  tables = read_tables(font)
+  cmap = read_cmap(tables[b"cmap"])
+  glyphs = glyph_data(tables)
+  units_per_em, = struct.unpack_from(">H", tables[b"head"], 18)
+  # FreeType draws .notdef for unmapped characters, for unmapped white space (the fonts under
+  # src/fonts/ lack a space) that's kept as an empty glyph with its advance
+  codepoints = sorted(ord(c) for c in chars if (ord(c) in cmap or c.isspace()) and ord(c) <= 0xFFFF)
+  gids = [cmap.get(c, 0) for c in codepoints]
+  kerning = kerning_pairs(tables)
+
+  bitmaps = bytearray()
+  result = []
+  for size in sizes:
+    scale = size / units_per_em
+    baseline = round(ascender(tables) * scale)
+    transform = lambda x, y: (x * scale, baseline - y * scale)
+    metrics = []
+    for gid in gids:
+      contours = glyph_contours(glyphs, gid) if gid else []
+      polygons = [flatten(c, transform) for c in contours if len(c) > 1]
+      left, top, width, height, alpha = rasterize(polygons)
+      offset = len(bitmaps)
+      for row in range(height):
+        values = alpha[row * width:(row + 1) * width] + [0]
+        bitmaps += bytes((values[i] << 4) | values[i + 1] for i in range(0, width, 2))
+      advance = round(horizontal_metrics(tables, gid) * scale)
+      metrics.append((offset, width, height, left, top, advance))
+    index = {gid: i for i, gid in enumerate(gids)}
+    pairs = sorted((index[l], index[r], round(v * scale)) for (l, r), v in kerning.items()
+                   if l in index and r in index and round(v * scale) != 0)
+    result.append((size, metrics, pairs))
+  return codepoints, bytes(bitmaps), result
+
+
+def write_if_changed(path, content):
+  """Keeps the file (and its timestamp) untouched if the content is the same."""
+  os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+  if os.path.isfile(path):
+    with open(path, encoding="utf-8") as f:
+      if f.read() == content:
+        return
+  with open(path, "w", encoding="utf-8") as f:
+    f.write(content)
+
+
+def hex_lines(values, fmt, per_line):
+  return ["  " + ", ".join(fmt % v for v in values[i:i + per_line]) + ","
+          for i in range(0, len(values), per_line)]
+
+
+def write_header(font, source, chars, path):
+  printable = "".join(sorted(c for c in chars if c.isprintable()))
+  lines = ["// Generated by tools/fonts.py from %s, do not edit." % source,
+           "// Glyphs: %s" % printable, "", "#pragma once", "",
+           "const unsigned char %s[%d] = {" % (ARRAY_NAME, len(font))]
+  lines += hex_lines(font, "0x%02X", 16)
+  lines += ["};", ""]
+  write_if_changed(path, "\n".join(lines))
+
+
+def write_bitmap_header(font, source, chars, sizes, path):
+  """Rasterizes font into a header defining BITMAP_FONT_NAME, returns its size in bytes. Nothing
+  is done if the header was generated from the same input."""
+  with open(__file__, "rb") as f:
+    tool = f.read()
+  key = "// Input: %08X" % zlib.crc32(font + tool + repr((sorted(chars), sizes)).encode())
+  if os.path.isfile(path):
+    with open(path, encoding="utf-8") as f:
+      lines = f.read().split("\n")
+      if key in lines:
+        return int(lines[lines.index(key) + 1].split()[-2])
+
+  codepoints, bitmaps, per_size = bitmap_font(font, chars, sizes)
+  total = len(bitmaps) + 2 * len(codepoints) + sum(10 * len(m) + 6 * len(k) for _, m, k in per_size)
+  prefix = BITMAP_FONT_PREFIX
+  lines = ["// Generated by tools/fonts.py from %s, do not edit." % source, key,
+           "// Size: %d bytes" % total, "", "#pragma once", "", '#include "BitmapFont.h"', "",
+           "static const uint16_t %s_CODEPOINTS[] = {" % prefix]
+  lines += hex_lines(codepoints, "0x%04X", 12)
+  lines += ["};", "", "static const uint8_t %s_BITMAPS[] = {" % prefix]
+  lines += hex_lines(bitmaps, "0x%02X", 16)
+  lines += ["};", ""]
+  entries = []
+  for size, metrics, pairs in per_size:
+    lines.append("static const BitmapFontGlyph %s_GLYPHS_%d[] = {" % (prefix, size))
+    # a backslash would continue the comment on the next line
+    lines += ["  {%d, %d, %d, %d, %d, %d}, // %s" % (m + (chr(c) if chr(c) != "\\" else "",))
+              for m, c in zip(metrics, codepoints)]
+    lines += ["};", ""]
+    kerning = "nullptr"
+    if pairs:
+      kerning = "%s_KERNING_%d" % (prefix, size)
+      lines.append("static const BitmapFontKerning %s[] = {" % kerning)
+      lines += ["  {%d, %d, %d}," % p for p in pairs]
+      lines += ["};", ""]
+    entries.append("  {%d, %s_GLYPHS_%d, %s, %d}," % (size, prefix, size, kerning, len(pairs)))
+  lines += ["static const BitmapFontSize %s_SIZES[] = {" % prefix] + entries + ["};", ""]
+  lines += ["const BitmapFont %s = {%s_CODEPOINTS, %d, %s_SIZES, %d, %s_BITMAPS};" % (
+            BITMAP_FONT_NAME, prefix, len(codepoints), prefix, len(sizes), prefix), ""]
+  write_if_changed(path, "\n".join(lines))
+  return total
+
+
+def ui_glyphs(project_dir, extra):
+  chars = string_glyphs([os.path.join(project_dir, p) for p in STRING_SOURCES])
+  chars.update(DEFAULT_EXTRA_GLYPHS + extra)
+  return {c for c in chars if c >= " "}
+
+
+def write_subset(font_header, out_path, project_dir=".", extra=""):
+  """Subsets font_header to the UI's glyphs into out_path, returns (original, subset) size."""
+  font = read_font_header(font_header)
+  chars = ui_glyphs(project_dir, extra)
+  reduced = subset(font, chars)
+  write_header(reduced, os.path.relpath(font_header, project_dir), chars, out_path)
+  return len(font), len(reduced)
+
+
+def write_bitmap_subset(font_header, out_path, project_dir=".", extra="",
+                        sizes=DEFAULT_BITMAP_SIZES):
+  """Rasterizes the UI's glyphs of font_header at sizes into out_path, returns its size in bytes."""
+  font = read_font_header(font_header)
+  return write_bitmap_header(font, os.path.relpath(font_header, project_dir),
+                             ui_glyphs(project_dir, extra), list(sizes), out_path)
+
+
+if __name__ == "__main__":
+  args = sys.argv[1:]
+  if len(args) in (3, 4) and args[0] == "--bitmap":
+    size = write_bitmap_subset(args[1], args[2], extra=args[3] if len(args) == 4 else "")
+    print("Rasterized %s at %s px into %d bytes." % (args[1], DEFAULT_BITMAP_SIZES, size))
+  elif len(args) in (2, 3):
+    before, after = write_subset(args[0], args[1], extra=args[2] if len(args) == 3 else "")
+    print("Subset %s from %d to %d bytes." % (args[0], before, after))
+  else:
+    sys.exit("usage: %s [--bitmap] <font header> <output header> [extra glyphs]" % sys.argv[0])
@@ -0,0 +1,284 @@
+# SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+# SPDX-License-Identifier: MIT
+
+"""Convert the BMP icons under data/ into formats that are cheaper to draw on the device.
+
+Can be used stand-alone or through tools/pio_fsimage.py while building the LittleFS image:
+
+  python3 tools/icons.py data/ out/           -> copy of data/ with all icons in out/icons.atlas
+  python3 tools/icons.py --files data/ out/        -> one .565 file per icon
+  python3 tools/icons.py --prle-files data/ out/   -> one compressed .prl file per icon
+  python3 tools/icons.py --embedded data/ out/     -> C++ headers for -D ICONS_EMBEDDED
+"""
+
+import os
+import shutil
+import struct
+import sys
+
+# Directories below data/ holding icons that GfxUi::drawIcon() draws
+ICON_DIRS = ["weather", "weather-small", "wind"]
+
+# Raw RGB565 icon: magic, width, height (little-endian) followed by big-endian ("pre-swapped")
+# RGB565 pixels in top-down row order. Must match RGB565_MAGIC & friends in src/GfxUi.h.
+RGB565_MAGIC = b"R565"
+RGB565_EXTENSION = ".565"
+
+# Palette-indexed, run-length encoded icons, see src/PaletteRle.h for the format.
+PRLE_MAGIC = b"PRLE"
+PRLE_EXTENSION = ".prl"
+PRLE_MAX_PALETTE_SIZE = 256
+
+# Icon atlas: all icons in one file, see write_atlas() for the layout. Must match ATLAS_* in
+# src/GfxUi.h.
+ATLAS_MAGIC = b"ICAT"
+ATLAS_VERSION = 2
+ATLAS_FILENAME = "icons.atlas"
+ATLAS_FORMAT_RGB565 = 0
+ATLAS_FORMAT_PRLE = 1
+
+
+class Bitmap:
+  def __init__(self, width, height, pixels):
+    self.width = width
+    self.height = height
+    # top-down list of RGB565 values
+    self.pixels = pixels
+
+
+def rgb565(r, g, b):
+  return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def read_bmp(path):
+  """Reads an uncompressed 8- or 24-bit BMP (any header version) into a Bitmap."""
+  with open(path, "rb") as f:
+    data = f.read()
+  if data[0:2] != b"BM":
+    raise ValueError("%s: not a BMP file" % path)
+  pixel_offset, = struct.unpack_from("<I", data, 10)
+  header_size, width, height, planes, bpp, compression = struct.unpack_from("<IiiHHI", data, 14)
+  if planes != 1 or compression != 0 or bpp not in (8, 24):
+    raise ValueError("%s: unsupported BMP (%d bpp, compression %d)" % (path, bpp, compression))
+
+  palette = []
+  if bpp == 8:
+    colors_used, = struct.unpack_from("<I", data, 46)
+    palette_offset = 14 + header_size
+    for i in range(colors_used or 256):
+      b, g, r = data[palette_offset + 4 * i:palette_offset + 4 * i + 3]
+      palette.append(rgb565(r, g, b))
+
+  bottom_up = height > 0
+  height = abs(height)
+  stride = (width * bpp // 8 + 3) & ~3
+  pixels = []
+  for row in range(height):
+    src_row = height - 1 - row if bottom_up else row
+    start = pixel_offset + src_row * stride
+    if bpp == 24:
+      for col in range(width):
+        b, g, r = data[start + 3 * col:start + 3 * col + 3]
+        pixels.append(rgb565(r, g, b))
+    else:
+      pixels.extend(palette[i] for i in data[start:start + width])
+  return Bitmap(width, height, pixels)
+
+
+def encode_pixels(bitmap):
+  return b"".join(struct.pack(">H", p) for p in bitmap.pixels)
+
+
+def encode_rgb565(bitmap):
+  header = RGB565_MAGIC + struct.pack("<HH", bitmap.width, bitmap.height)
+  return header + encode_pixels(bitmap)
+
+
+def encode_prle_stream(bitmap):
+  """Returns the PRLE stream (without magic) or None if the icon has too many colors."""
+  palette = sorted(set(bitmap.pixels))
+  if len(palette) > PRLE_MAX_PALETTE_SIZE:
+    return None
+  bits = 4 if len(palette) <= 16 else 8
+  lookup = {color: i for i, color in enumerate(palette)}
+  indices = [lookup[p] for p in bitmap.pixels]
+
+  out = bytearray(struct.pack("<HHHBB", bitmap.width, bitmap.height, len(palette), bits, 0))
+  for color in palette:
+    out += struct.pack(">H", color)
+
+  literal = []
+
+  def flush_literal():
+    while literal:
+      chunk = literal[:128]
+      del literal[:128]
+      out.append(len(chunk) - 1)
+      if bits == 8:
+        out.extend(chunk)
+      else:
+        padded = chunk + [0] * (len(chunk) % 2)
+        out.extend((padded[i] << 4) | padded[i + 1] for i in range(0, len(padded), 2))
+
+  i = 0
+  while i < len(indices):
+    run = 1
+    while i + run < len(indices) and run < 128 and indices[i + run] == indices[i]:
+      run += 1
+    # a run packet costs 2 bytes, shorter repetitions are cheaper as part of a literal
+    if run >= 3:
+      flush_literal()
+      out += bytes([0x80 | (run - 1), indices[i]])
+      i += run
+    else:
+      literal.append(indices[i])
+      i += 1
+  flush_literal()
+  return bytes(out)
+
+
+def encode_prle(bitmap):
+  stream = encode_prle_stream(bitmap)
+  return PRLE_MAGIC + stream if stream else None
+
+
+def icon_id(name):
+  """32-bit FNV-1a hash of the icon name as passed to GfxUi::drawIcon(), e.g. "/wind/N"."""
+  h = 0x811C9DC5
+  for c in name.encode("utf-8"):
+    h = ((h ^ c) * 0x01000193) & 0xFFFFFFFF
+  return h
+
+
+def find_icons(src_dir):
+  """Returns (icon name, BMP path) tuples for all icons below src_dir."""
+  result = []
+  for icon_dir in ICON_DIRS:
+    path = os.path.join(src_dir, icon_dir)
+    if not os.path.isdir(path):
+      continue
+    for filename in sorted(os.listdir(path)):
+      if filename.endswith(".bmp"):
+        result.append(("/%s/%s" % (icon_dir, filename[:-len(".bmp")]), os.path.join(path, filename)))
+  return result
+
+
+def write_atlas(icons, path):
+  """
+  Layout (all integers little-endian):
+  - header: magic "ICAT", uint16 version, uint16 number of icons
+  - index: one 16 byte entry per icon, sorted by icon ID for binary search on the device:
+    uint32 icon ID, uint32 absolute offset of the data, uint16 width, uint16 height, uint8 format,
+    3 bytes padding
+  - data, one block per icon, whichever format is smaller:
+    ATLAS_FORMAT_RGB565: big-endian RGB565 pixels, top-down
+    ATLAS_FORMAT_PRLE: PRLE stream as described in src/PaletteRle.h
+  """
+  entries = sorted(((icon_id(name), bitmap) for name, bitmap in icons), key=lambda e: e[0])
+  ids = [e[0] for e in entries]
+  if len(set(ids)) != len(ids):
+    raise ValueError("icon ID collision, rename one of the icons")
+
+  offset = 8 + 16 * len(entries)
+  index = b""
+  pixels = b""
+  for key, bitmap in entries:
+    block = encode_prle_stream(bitmap)
+    kind = ATLAS_FORMAT_PRLE
+    if not block or len(block) >= 2 * len(bitmap.pixels):
+      block = encode_pixels(bitmap)
+      kind = ATLAS_FORMAT_RGB565
+    index += struct.pack("<IIHHB3x", key, offset + len(pixels), bitmap.width, bitmap.height, kind)
+    pixels += block
+  with open(path, "wb") as f:
+    f.write(ATLAS_MAGIC + struct.pack("<HH", ATLAS_VERSION, len(entries)) + index + pixels)
+
+
+def write_if_changed(path, content):
+  """Keeps the file (and its timestamp) untouched if the content is the same."""
+  if os.path.isfile(path):
+    with open(path) as f:
+      if f.read() == content:
+        return
+  with open(path, "w") as f:
+    f.write(content)
+
+
+def write_embedded(src_dir, out_dir):
+  """
+  Generates the C++ headers for the ICONS_EMBEDDED build option:
+  - embedded_icons.h: the EmbeddedIcon enum
+  - embedded_icon_data.h: pre-swapped RGB565 pixels as constexpr arrays plus a table indexed by
+    EmbeddedIcon, to be included by GfxUi.cpp only
+  """
+  icons = [(name, read_bmp(path)) for name, path in find_icons(src_dir)]
+  os.makedirs(out_dir, exist_ok=True)
+  enums = ["".join(c if c.isalnum() else "_" for c in name[1:]).upper() for name, _ in icons]
+
+  header = ["// Generated by tools/icons.py from %s, do not edit." % src_dir, "", "#pragma once", "",
+            "#include <stdint.h>", "", "enum class EmbeddedIcon : uint16_t {"]
+  header += ["  %s," % e for e in enums]
+  header += ["  COUNT", "};", ""]
+  write_if_changed(os.path.join(out_dir, "embedded_icons.h"), "\n".join(header))
+
+  data = ["// Generated by tools/icons.py from %s, do not edit." % src_dir, "", "#pragma once", "",
+          '#include "embedded_icons.h"', ""]
+  for e, (name, bitmap) in zip(enums, icons):
+    # the values are byte-swapped so that they are in wire order in (little-endian) memory
+    values = ["0x%04X" % (((p >> 8) | (p << 8)) & 0xFFFF) for p in bitmap.pixels]
+    data.append("constexpr uint16_t ICON_%s_PIXELS[] = {" % e)
+    for i in range(0, len(values), 12):
+      data.append("  " + ", ".join(values[i:i + 12]) + ",")
+    data += ["};", ""]
+
+  data += ["typedef struct EmbeddedIconInfo {", "  uint32_t id;", "  uint16_t width;",
+           "  uint16_t height;", "  const uint16_t *pixels;", "} EmbeddedIconInfo;", "",
+           "// indexed by EmbeddedIcon, id as in icon_id()",
+           "constexpr EmbeddedIconInfo EMBEDDED_ICONS[] = {"]
+  for e, (name, bitmap) in zip(enums, icons):
+    data.append("  {0x%08X, %d, %d, ICON_%s_PIXELS}, // %s" % (icon_id(name), bitmap.width,
+                                                            bitmap.height, e, name))
+  data += ["};", ""]
+  write_if_changed(os.path.join(out_dir, "embedded_icon_data.h"), "\n".join(data))
+  return len(icons)
+
+
+def convert_tree(src_dir, dst_dir):
+  """Copies src_dir to dst_dir replacing all icon BMPs by a single icon atlas."""
+  if os.path.isdir(dst_dir):
+    shutil.rmtree(dst_dir)
+  shutil.copytree(src_dir, dst_dir, ignore=lambda d, names: ICON_DIRS if d == src_dir else [])
+  icons = [(name, read_bmp(path)) for name, path in find_icons(src_dir)]
+  write_atlas(icons, os.path.join(dst_dir, ATLAS_FILENAME))
+  return len(icons)
+
+
+def convert_files(src_dir, dst_dir, compressed=False):
+  """
+  Writes one file per icon BMP below src_dir into the same layout below dst_dir: .565 or, if
+  compressed is set, .prl (falling back to .565 for icons with too many colors).
+  """
+  icons = find_icons(src_dir)
+  for name, path in icons:
+    bitmap = read_bmp(path)
+    data = encode_prle(bitmap) if compressed else None
+    extension = PRLE_EXTENSION if data else RGB565_EXTENSION
+    out = os.path.join(dst_dir, name.lstrip("/") + extension)
+    os.makedirs(os.path.dirname(out), exist_ok=True)
+    with open(out, "wb") as f:
+      f.write(data or encode_rgb565(bitmap))
+  return len(icons)
+
+
+if __name__ == "__main__":
+  args = sys.argv[1:]
+  if len(args) == 3 and args[0] in ("--files", "--prle-files"):
+    count = convert_files(args[1], args[2], compressed=args[0] == "--prle-files")
+    print("Converted %d icons." % count)
+  elif len(args) == 3 and args[0] == "--embedded":
+    print("Generated headers for %d icons." % write_embedded(args[1], args[2]))
+  elif len(args) == 2:
+    print("Packed %d icons into %s." % (convert_tree(args[0], args[1]), ATLAS_FILENAME))
+  else:
+    sys.exit("usage: %s [--files | --prle-files | --embedded] <data dir> <output dir>"
+             % sys.argv[0])
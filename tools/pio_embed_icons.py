@@ -0,0 +1,20 @@
+# SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+# SPDX-License-Identifier: MIT
+
+# PlatformIO extra script: with -D ICONS_EMBEDDED the icons below data/ are compiled into the
+# firmware. The headers are generated into the build directory (see tools/icons.py).
+
+import os
+import sys
+
+Import("env")
+
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))
+import icons
+
+defines = env.ParseFlags(env.get("BUILD_FLAGS", []))["CPPDEFINES"]
+if any((d[0] if isinstance(d, (list, tuple)) else d) == "ICONS_EMBEDDED" for d in defines):
+  out_dir = os.path.join(env.subst("$PROJECT_BUILD_DIR"), env.subst("$PIOENV"), "generated")
+  count = icons.write_embedded(env.subst("$PROJECT_DATA_DIR"), out_dir)
+  print("Embedding %d icons, headers in %s" % (count, out_dir))
+  env.Append(CPPPATH=[out_dir])
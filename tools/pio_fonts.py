@@ -0,0 +1,29 @@
+# SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+# SPDX-License-Identifier: MIT
+
+# PlatformIO extra script: generates into the build directory (see tools/fonts.py)
+# - ui_font.h: the font chosen with custom_ui_font reduced to the glyphs the UI draws, only that
+#   font is compiled in
+# - ui_bitmap_font.h: the same glyphs pre-rasterized at the sizes in custom_ui_font_sizes
+
+import os
+import sys
+
+Import("env")
+
+project_dir = env.subst("$PROJECT_DIR")
+sys.path.insert(0, os.path.join(project_dir, "tools"))
+import fonts
+
+name = env.GetProjectOption("custom_ui_font", "open-sans")
+extra = env.GetProjectOption("custom_ui_font_extra_glyphs", "")
+sizes = [int(s) for s in env.GetProjectOption("custom_ui_font_sizes", "").replace(",", " ").split()]
+font_header = os.path.join(project_dir, "src", "fonts", name + ".h")
+out_dir = os.path.join(env.subst("$PROJECT_BUILD_DIR"), env.subst("$PIOENV"), "generated")
+before, after = fonts.write_subset(font_header, os.path.join(out_dir, "ui_font.h"), project_dir,
+                                   extra)
+print("Font %s subset from %d to %d bytes, header in %s" % (name, before, after, out_dir))
+bitmap = fonts.write_bitmap_subset(font_header, os.path.join(out_dir, "ui_bitmap_font.h"),
+                                   project_dir, extra, sizes or fonts.DEFAULT_BITMAP_SIZES)
+print("Bitmap font: %d bytes" % bitmap)
+env.Append(CPPPATH=[out_dir])
@@ -0,0 +1,22 @@
+# SPDX-FileCopyrightText: 2023 ThingPulse Ltd., https://thingpulse.com
+# SPDX-License-Identifier: MIT
+
+# PlatformIO extra script: builds the LittleFS image from a converted copy of data/ rather than
+# from data/ itself. The icons are turned into the formats GfxUi draws fastest (see tools/icons.py).
+
+import os
+import sys
+
+Import("env")
+
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "tools"))
+import icons
+
+FS_TARGETS = {"buildfs", "uploadfs", "uploadfsota"}
+
+if FS_TARGETS.intersection(COMMAND_LINE_TARGETS):
+  src_dir = env.subst("$PROJECT_DATA_DIR")
+  dst_dir = os.path.join(env.subst("$PROJECT_BUILD_DIR"), env.subst("$PIOENV"), "fsdata")
+  count = icons.convert_tree(src_dir, dst_dir)
+  print("Packed %d icons from %s into %s" % (count, src_dir, dst_dir))
+  env.Replace(PROJECT_DATA_DIR=dst_dir)